@@ -0,0 +1,42 @@
+#!/bin/sh
+# times 'print x >> file' run in a loop for one or more eggsh binaries
+# pass the binary built from the previous version as well to compare before and after
+#
+# usage: bench/builtin_redirect_bench.sh [-n number of commands] <path to eggsh binary>...
+
+COUNT=5000
+if [ "$1" = "-n" ]; then
+    COUNT=$2
+    shift 2
+fi
+
+if [ $# -eq 0 ]; then
+    echo "usage: $0 [-n number of commands] <path to eggsh binary>..." >&2
+    exit 1
+fi
+
+INPUT=$(mktemp)
+OUTPUT=$(mktemp)
+trap 'rm -f "$INPUT" "$OUTPUT"' EXIT
+
+# one redirected print per line
+i=0
+while [ "$i" -lt "$COUNT" ]; do
+    echo "print x >> $OUTPUT"
+    i=$((i + 1))
+done > "$INPUT"
+echo "exit" >> "$INPUT"
+
+for eggsh in "$@"; do
+    # '>>' appends to an existing file
+    : > "$OUTPUT"
+
+    # the input is piped, since older binaries fork for each print and the
+    # children would otherwise move the shared offset of an input file
+    start=$(date +%s%N)
+    cat "$INPUT" | "$eggsh" > /dev/null 2>&1
+    end=$(date +%s%N)
+
+    awk -v b="$eggsh" -v n="$COUNT" -v ns="$((end - start))" -v lines="$(wc -l < "$OUTPUT")" \
+        'BEGIN { printf "%s: %d commands %.3f s %.1f commands/s (%d lines written)\n", b, n, ns / 1e9, n / (ns / 1e9), lines }'
+done
@@ -0,0 +1,48 @@
+#!/bin/sh
+# times the expansion of server-*.log in a temporary directory with many files
+# a second pattern in the same command shows the reuse of the directory listing read by the first one
+# 'sh' expanding the same pattern is the baseline, the words are printed to /dev/null in every case
+#
+# usage: bench/glob_bench.sh <path to eggsh binary> [number of files] [iterations]
+
+EGGSH=${1:?usage: $0 <path to eggsh binary> [number of files] [iterations]}
+FILES=${2:-100000}
+ITERATIONS=${3:-10}
+
+case "$EGGSH" in
+    /*) ;;
+    *) EGGSH="$(pwd)/$EGGSH" ;;
+esac
+
+DIRECTORY=$(mktemp -d)
+trap 'rm -rf "$DIRECTORY"' EXIT
+cd "$DIRECTORY" || exit 1
+
+# half of the files match the pattern
+awk -v n="$FILES" 'BEGIN { for (i = 0; i < n; i++) print (i % 2 == 0 ? "server-" i ".log" : "server-" i ".txt") }' |
+    xargs touch
+
+# runs a command in a shell and prints the nanoseconds it took, without the time to start the shell
+time_command() {
+    start=$(date +%s%N)
+    "$1" -c '' > /dev/null 2>&1
+    end=$(date +%s%N)
+    startup=$((end - start))
+
+    start=$(date +%s%N)
+    "$1" -c "$2" > /dev/null 2>&1
+    end=$(date +%s%N)
+
+    echo $((end - start - startup))
+}
+
+single=$(time_command "$EGGSH" "for i in {1..$ITERATIONS}; do print server-*.log; done")
+double=$(time_command "$EGGSH" "for i in {1..$ITERATIONS}; do print server-*.log server-1*.log; done")
+baseline=$(time_command sh "for i in \$(seq $ITERATIONS); do echo server-*.log; done")
+
+awk -v files="$FILES" -v n="$ITERATIONS" -v single="$single" -v double="$double" -v baseline="$baseline" 'BEGIN {
+    printf "files: %d, iterations: %d\n", files, n
+    printf "eggsh glob:          %.3f ms per pattern\n", single / n / 1e6
+    printf "eggsh glob (cached): %.3f ms per pattern\n", (double - single) / n / 1e6
+    printf "sh glob:             %.3f ms per pattern\n", baseline / n / 1e6
+}'
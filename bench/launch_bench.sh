@@ -0,0 +1,28 @@
+#!/bin/sh
+# compares how many external commands per second eggsh can launch
+# with the posix_spawn launcher and with the fork-plus-exec fallback
+#
+# usage: bench/launch_bench.sh <path to eggsh binary> [number of commands]
+
+EGGSH=${1:?usage: $0 <path to eggsh binary> [number of commands]}
+COUNT=${2:-5000}
+
+INPUT=$(mktemp)
+trap 'rm -f "$INPUT"' EXIT
+
+# one short-lived external command per line
+i=0
+while [ "$i" -lt "$COUNT" ]; do
+    echo "true"
+    i=$((i + 1))
+done > "$INPUT"
+echo "exit" >> "$INPUT"
+
+for launcher in fork spawn; do
+    start=$(date +%s%N)
+    EGGSH_LAUNCHER=$launcher "$EGGSH" < "$INPUT" > /dev/null 2>&1
+    end=$(date +%s%N)
+
+    awk -v l="$launcher" -v n="$COUNT" -v ns="$((end - start))" \
+        'BEGIN { printf "%-6s %8d commands %10.3f s %12.1f commands/s\n", l, n, ns / 1e9, n / (ns / 1e9) }'
+done
@@ -0,0 +1,56 @@
+#!/bin/sh
+# times how fast eggsh lexes and parses long lines of words, quotes and operators
+# each line is the body of a function definition, so it is lexed and parsed but never run
+# 'sh -n' reads the same script without running it as a baseline
+#
+# usage: bench/lexer_bench.sh <path to eggsh binary> [line length in bytes] [number of lines]
+
+EGGSH=${1:?usage: $0 <path to eggsh binary> [line length in bytes] [number of lines]}
+LENGTH=${2:-1048576}
+LINES=${3:-20}
+
+PATTERN=$(mktemp)
+INPUT=$(mktemp)
+EMPTY=$(mktemp)
+trap 'rm -f "$PATTERN" "$INPUT" "$EMPTY"' EXIT
+
+cat > "$PATTERN" << 'END'
+word 'single quoted' "double $HOME quoted" esc\ aped a&&b c||d e|f >> out ; 
+END
+
+# repeat the pattern up to the line length, in the body of f() { ... }
+awk -v length_limit="$LENGTH" -v lines="$LINES" '
+    NR == 1 { pattern = $0 " " }
+    END {
+        count = int(length_limit / length(pattern))
+        line = ""
+        for (i = 0; i < count; i++) {
+            line = line pattern
+        }
+        for (i = 0; i < lines; i++) {
+            print "f() { " line "}"
+        }
+    }' "$PATTERN" > "$INPUT"
+
+BYTES=$(wc -c < "$INPUT")
+
+# the time to start each shell is taken off
+for shell in "$EGGSH" sh; do
+    if [ "$shell" = sh ]; then
+        set -- sh -n
+    else
+        set -- "$shell"
+    fi
+
+    start=$(date +%s%N)
+    "$@" "$EMPTY" > /dev/null 2>&1
+    end=$(date +%s%N)
+    startup=$((end - start))
+
+    start=$(date +%s%N)
+    "$@" "$INPUT" > /dev/null 2>&1
+    end=$(date +%s%N)
+
+    awk -v s="$*" -v bytes="$BYTES" -v ns="$((end - start - startup))" \
+        'BEGIN { printf "%-24s %10d bytes %10.3f s %10.1f MB/s\n", s, bytes, ns / 1e9, bytes / (ns / 1e9) / 1e6 }'
+done
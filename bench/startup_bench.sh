@@ -0,0 +1,87 @@
+#!/bin/sh
+# times how long eggsh takes to start, over many runs, and prints percentiles
+# - exec to exit of '<shell> -c ''', for eggsh and for sh as a baseline
+# - exec to the first prompt, with eggsh started in a pseudo-terminal (needs python3 for the pseudo-terminal)
+#
+# usage: bench/startup_bench.sh <path to eggsh binary> [runs]
+
+EGGSH=${1:?usage: $0 <path to eggsh binary> [runs]}
+RUNS=${2:-200}
+
+TIMES=$(mktemp)
+trap 'rm -f "$TIMES"' EXIT
+
+# prints min, p50, p90, p99 and max of the nanoseconds in $TIMES, in milliseconds
+print_percentiles() {
+    sort -n "$TIMES" | awk -v label="$1" '
+        { times[NR] = $1 }
+        END {
+            printf "%-28s min %.3f ms, p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n", label,
+                times[1] / 1e6, times[int(NR * 0.5) + 1] / 1e6, times[int(NR * 0.9) + 1] / 1e6,
+                times[int(NR * 0.99) + 1] / 1e6, times[NR] / 1e6
+        }'
+}
+
+# the time taken by 'date' itself is measured first and taken off each run
+overhead=$(
+    i=0
+    while [ "$i" -lt 20 ]; do
+        start=$(date +%s%N)
+        end=$(date +%s%N)
+        echo $((end - start))
+        i=$((i + 1))
+    done | sort -n | awk '{ times[NR] = $1 } END { print times[int(NR / 2) + 1] }'
+)
+
+echo "runs: $RUNS"
+
+for shell in "$EGGSH" sh; do
+    i=0
+    while [ "$i" -lt "$RUNS" ]; do
+        start=$(date +%s%N)
+        "$shell" -c '' > /dev/null 2>&1
+        end=$(date +%s%N)
+        echo $((end - start - overhead))
+        i=$((i + 1))
+    done > "$TIMES"
+
+    print_percentiles "$(basename "$shell") -c '':"
+done
+
+if ! command -v python3 > /dev/null 2>&1; then
+    echo "python3 not found, exec to prompt is not measured"
+    exit 0
+fi
+
+# the shell gets a window size, otherwise linenoise asks the terminal for its width and waits for the answer
+# once the prompt has been printed the shell is sent 'exit'
+python3 - "$EGGSH" "$RUNS" > "$TIMES" << 'END'
+import fcntl, os, pty, select, struct, sys, termios, time
+
+shell, runs = sys.argv[1], int(sys.argv[2])
+for _ in range(runs):
+    start = time.monotonic_ns()
+    pid, fd = pty.fork()
+    if pid == 0:
+        fcntl.ioctl(0, termios.TIOCSWINSZ, struct.pack("HHHH", 24, 80, 0, 0))
+        os.execv(shell, [shell])
+    output = b""
+    while b"eggsh> " not in output and select.select([fd], [], [], 5)[0]:
+        output += os.read(fd, 4096)
+    print(time.monotonic_ns() - start if b"eggsh> " in output else -1)
+    os.write(fd, b"exit\r")
+    try:
+        while os.read(fd, 4096):
+            pass
+    except OSError:
+        pass
+    os.close(fd)
+    os.waitpid(pid, 0)
+END
+
+if grep -q -- '^-1$' "$TIMES"; then
+    echo "the prompt was not shown within 5 s"
+    exit 1
+fi
+
+print_percentiles "$(basename "$EGGSH") to prompt:"
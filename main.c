@@ -1,1287 +1,6163 @@
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <ctype.h>
 #include <unistd.h>
 #include <string.h>
 #include <fcntl.h>
+#include <glob.h>
+#include <limits.h>
+#include <dirent.h>
+#include <signal.h>
+#include <errno.h>
+#include <spawn.h>
+#include <time.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 #include "linenoise.h"
 
 #define MAX_LENGTH 512
-#define NUM_INTERNAL_COMMANDS 5
+#define NUM_INTERNAL_COMMANDS 13
+#define COMMAND_HASH_SIZE 64
+#define MAX_JOBS 64
 
 #define clear_terminal() printf("\033[H\033[J")
 #define TERMINAL_TITLE "Eggshell Terminal"
 
-//shell variables
-char PATH[MAX_LENGTH] = {0};
+//shell variables, these point to the values in the variable store
+char *PATH = "";
 char *PROMPT = "eggsh> ";
-char CWD[MAX_LENGTH] = {0};
-char USER[MAX_LENGTH] = {0};
-char HOME[MAX_LENGTH] = {0};
-char SHELL[MAX_LENGTH] = {0};
-char TERMINAL[MAX_LENGTH] = {0};
+char *CWD = "";
+char *USER = "";
+char *HOME = "";
+char *SHELL = "";
+char *TERMINAL = "";
 int EXITCODE = 0;
 char EXITCODE_S[MAX_LENGTH] = "0";
 
-//user created variables
-char USER_VAR_NAMES[MAX_LENGTH][MAX_LENGTH];
-char USER_VAR_VALUES[MAX_LENGTH][MAX_LENGTH];
+//stdout of the shell process, stdout itself is swapped with a memory stream while a $(...) runs in the shell
+FILE *REAL_STDOUT = NULL;
+
+//1 if the commands are typed in a terminal, 0 if they come from -c, a script given to the shell or a redirected input
+int INTERACTIVE = 0;
+
+//resource usage of the last foreground command, filled in from wait4
+struct command_usage {
+    double user_time; //user CPU time in seconds
+    double system_time; //system CPU time in seconds
+    double wall_time; //wall-clock time in seconds
+    long max_rss; //largest maximum resident set size of the processes, in kilobytes
+    long voluntary_switches; //voluntary context switches
+    long involuntary_switches; //involuntary context switches
+};
+
+struct command_usage LAST_USAGE = {0};
+
+//string values of LAST_USAGE returned as shell variables
+char LASTUSER_S[MAX_LENGTH] = "0.000000";
+char LASTSYS_S[MAX_LENGTH] = "0.000000";
+char LASTWALL_S[MAX_LENGTH] = "0.000000";
+char LASTRSS_S[MAX_LENGTH] = "0";
+
+#define VARIABLE_READONLY 1 //the value is kept up to date by the shell and cannot be set
+#define VARIABLE_EXPORTED 2 //the variable is passed to external commands in ENVP
+#define VARIABLE_INHERITED 4 //the variable came from the environment of the shell and has not been set since
+#define VARIABLE_INTEGER 8 //integer holds the value parsed as a number, cleared whenever the value changes
+#define VARIABLE_STALE 16 //the value is worked out again by on_get the next time it is read
+
+//variable in the variable store, the name is allocated together with the struct
+struct variable {
+    unsigned int hash;
+    char *value;
+    size_t capacity; //bytes allocated for the value, 0 if the value is a buffer of the shell
+    int flags; //VARIABLE_ flags
+    char **global; //global such as PATH which points to the value, NULL for user created variables
+    int (*on_set)(const char value[]); //called before the value is changed, returns 0 if it can be changed
+    void (*on_get)(struct variable *variable); //stores the value when it is read while VARIABLE_STALE is set
+    int env_index; //position of the NAME=VALUE entry in ENVP, -1 if the variable is not exported
+    char *env_entry; //NAME=VALUE entry in ENVP
+    long long integer; //value as a number, only valid if VARIABLE_INTEGER is set
+    char name[];
+};
+
+//open addressing hash table with every variable, including the shell variables
+struct variable **VARIABLES = NULL;
+size_t VARIABLE_CAPACITY = 0; //number of slots, always a power of two
+
+//variables in the order they were created, used to print them
+struct variable **VARIABLE_ORDER = NULL;
+size_t VARIABLE_COUNT = 0;
+
+//environment passed to external commands, an entry is only rebuilt when its exported variable changes
+char **ENVP = NULL;
+struct variable **ENVP_VARIABLES = NULL; //variable of each entry in ENVP
+size_t ENVP_COUNT = 0;
+size_t ENVP_CAPACITY = 0;
+
+//array that stores the internal commands, more commands can be added here in the future
+const char *const INTERNAL_COMMANDS[NUM_INTERNAL_COMMANDS] = {
+        "exit", "print", "chdir", "all", "source", "hash", "jobs", "wait", "times", "export", "unset", "args", "return"
+};
+
+//empty list of arguments, used when no command is being run
+char *NO_ARGS[1] = {NULL};
+
+//script read by 'source', mapped into memory if it is a file, otherwise read in blocks
+//lines are handed out as views into the data, with the \n replaced by \0
+struct script_reader {
+    int fd;
+    char *data;
+    size_t size; //bytes in data
+    size_t position; //start of the next line
+    size_t capacity; //bytes allocated for data when it is read in blocks, 0 if the file is mapped
+    int end_of_file; //1 once everything has been read into data
+    int lines_given; //1 if a line has been handed out from the current block, so it cannot be moved
+    char **retired; //earlier blocks which lines may still point into, freed before the next line of the script
+    int retired_count;
+};
+
+//bytes read at a time from a script which cannot be mapped, such as a pipe
+#define SCRIPT_BLOCK_SIZE (64 * 1024)
+
+//1 if external commands are launched through posix_spawn, 0 if the fork path is used
+//can be changed by setting EGGSH_LAUNCHER=fork in the environment before starting the shell
+int USE_POSIX_SPAWN = 1;
+
+//environment the shell was started with, only read once to fill the variable store
+extern char **environ;
+
+//entry in the table of external commands which have already been found in PATH
+struct command_hash_entry {
+    char *name;
+    char *path;
+    int hits;
+    struct command_hash_entry *next;
+};
+
+//hash table of command names to absolute paths, similar to the hash builtin in bash
+struct command_hash_entry *COMMAND_HASH[COMMAND_HASH_SIZE];
+
+//change to a file descriptor made by a redirection, the changes are made in order with dup2
+struct fd_action {
+    int target_fd; //file descriptor which is changed
+    int source_fd; //file descriptor which is copied onto target_fd, -1 to close target_fd
+};
+
+//redirections of one command, with the files already opened by the shell
+struct redirection_plan {
+    struct fd_action *actions;
+    int action_count;
+    int *opened_fds; //files opened for the redirections, closed by the shell once the command has started
+    int opened_count;
+};
+
+//describes the file descriptors and process group a child process is launched with
+struct launch_options {
+    int stdin_fd; //fd which becomes STDIN of the child, -1 to keep the one of the shell
+    int stdout_fd; //fd which becomes STDOUT of the child, -1 to keep the one of the shell
+    const struct redirection_plan *plan; //redirections made after the pipes are connected, NULL if there are none
+    pid_t pgid; //process group the child joins, 0 for a new group, -1 to stay in the group of the shell
+};
+
+//a pipeline or command started in the background with '&'
+struct job {
+    int id; //number used to refer to the job, 0 if the slot in the job table is free
+    pid_t pgid; //process group of the job
+    pid_t *pids; //pids of the processes in the job, each one is set to 0 once it has been reaped
+    int process_count; //number of processes in the job
+    int running; //number of processes which have not been reaped yet
+    int exit_code; //exit code of the last process in the job
+    char *command; //the input which started the job
+};
+
+//table of background jobs, the processes are reaped by the SIGCHLD handler
+struct job JOBS[MAX_JOBS];
+
+//types of the tokens produced by the lexer
+enum token_type {
+    TOKEN_WORD,
+    TOKEN_SEMICOLON, //';'
+    TOKEN_BACKGROUND, //'&'
+    TOKEN_AND, //'&&'
+    TOKEN_OR, //'||'
+    TOKEN_PIPE, //'|'
+    TOKEN_REDIRECT_OUT, //'>'
+    TOKEN_REDIRECT_APPEND, //'>>'
+    TOKEN_REDIRECT_IN, //'<'
+    TOKEN_HERE_STRING, //'<<<'
+    TOKEN_HERE_DOCUMENT, //'<<', the word after it is replaced by the lines up to the delimiter
+    TOKEN_DUP_OUT, //'>&'
+    TOKEN_DUP_IN, //'<&'
+    TOKEN_READ_WRITE, //'<>'
+    TOKEN_OUT_ALL, //'&>'
+    TOKEN_APPEND_ALL, //'&>>'
+    TOKEN_IO_NUMBER, //digits straight before a redirection, such as the 2 in '2>'
+    TOKEN_NEWLINE //end of a line inside an 'if', 'while' or 'for' which goes on to the next line
+};
+
+//flags describing what a word contains, a word without any flags is used as it is without expanding it
+#define WORD_QUOTED 1 //the word contains ' or "
+#define WORD_ESCAPED 2 //the word contains a backslash
+#define WORD_DOLLAR 4 //the word contains a $ outside single quotes
+#define WORD_HERE_DOCUMENT 8 //the word is the body of a here-document, only $ and \ are special in it
+#define WORD_GLOB 16 //the word contains *, ? or [ outside quotes, so it is matched against file names
+#define WORD_BRACE 32 //the word contains { outside quotes, so it may have a brace expansion such as {a,b} or {1..9}
+
+//token produced by the lexer, words point into the input line, which is split in place
+struct token {
+    enum token_type type;
+    char *text; //the word as it was entered, or the operator, terminated by \0
+    int length; //length of the text
+    int flags; //WORD_ flags of a word
+};
+
+//growable vector of tokens for one input line
+struct token_list {
+    struct token *tokens;
+    int count;
+    int capacity;
+};
+
+//one element of a compiled glob pattern
+enum glob_element_type {
+    GLOB_LITERAL, //matches one given character
+    GLOB_ANY_CHARACTER, //'?'
+    GLOB_ANY_STRING, //'*'
+    GLOB_CLASS //'[...]', matches any character in the set
+};
+
+struct glob_element {
+    enum glob_element_type type;
+    unsigned char character; //character of a GLOB_LITERAL
+    unsigned char *set; //bitmap of the 256 characters matched by a GLOB_CLASS
+};
+
+//path component of a glob pattern compiled once, before it is matched against every name in a directory
+struct glob_pattern {
+    struct glob_element *elements;
+    int element_count;
+    int wildcards; //1 if the component has *, ? or [...], otherwise it is a plain name
+    int matches_dot; //1 if the component starts with '.', only then names starting with '.' are matched
+    const char *prefix; //characters every match starts with, used to reject names before matching
+    size_t prefix_length;
+    const char *suffix; //characters every match ends with, only set if the component has a '*'
+    size_t suffix_length;
+};
+
+//names in a directory read for glob expansion, kept in the line arena until a command is run
+struct glob_directory {
+    char *path;
+    char **names;
+    unsigned char *types; //d_type of every name, DT_UNKNOWN if the file system does not give it
+    int count;
+    struct glob_directory *next;
+};
+
+//directories read while expanding the current command, so a directory matched by several patterns is read once
+//commands can change directories, so the cache is emptied before the words of each command are expanded
+struct glob_directory *GLOB_CACHE = NULL;
+
+//part of a word with a brace expansion, the words are made by joining one choice of every part
+enum brace_part_type {
+    BRACE_TEXT, //text outside the braces
+    BRACE_LIST, //'{a,b,c}', every alternative can have braces of its own
+    BRACE_RANGE //'{1..9}', '{1..9..2}' or '{a..z}'
+};
+
+struct brace_expansion;
+
+struct brace_part {
+    enum brace_part_type type;
+    const char *text; //text of a BRACE_TEXT part
+    int length;
+    struct brace_expansion **alternatives; //alternatives of a BRACE_LIST part
+    int alternative_count;
+    int alternative; //alternative which is used for the current word
+    long long start, end, step; //a BRACE_RANGE part goes from start to end, step is negative if it counts down
+    long long current; //number which is used for the current word
+    int width; //numbers are padded with zeros to this width if the range was written with leading zeros
+    int letters; //1 if the range is of letters such as {a..z}
+};
+
+//word with brace expansions, the words are produced one at a time like the digits of a counter
+struct brace_expansion {
+    struct brace_part *parts;
+    int part_count;
+};
+
+//words of a command produced one at a time as they are expanded, so brace expansions and globs are not stored all at once
+struct word_source {
+    struct interpreter *interpreter; //frame the words are expanded in
+    const struct token *tokens;
+    int token_count;
+    int position; //next token to expand
+    struct brace_expansion *braces; //brace expansion of the current token, NULL if there is none
+    int braces_finished; //1 once the last word of the brace expansion has been produced
+    int brace_flags; //WORD_ flags of the words made by the brace expansion
+    char *buffer; //text of the current word of the brace expansion
+    size_t buffer_capacity;
+    char **matches; //glob matches of the current word which have not been produced yet
+    int match_count;
+    int match_position;
+    int temporary; //1 if the last word is in buffer, which is reused for the next word
+};
+
+//number of 'if', 'while' and 'for' commands the parser is inside of
+int PARSE_DEPTH = 0;
+
+//set when the tokens end inside an 'if', 'while' or 'for', so the command goes on to the next line
+int PARSE_INCOMPLETE = 0;
+
+//path with the 8 bytes after the prefix shared by all the paths packed into a number, so most comparisons are one number
+struct sort_key {
+    unsigned long long key;
+    char *text;
+};
+
+//entry returned by the getdents64 system call
+struct directory_entry64 {
+    unsigned long long inode;
+    long long offset;
+    unsigned short record_length;
+    unsigned char type;
+    char name[];
+};
+
+//bytes read from a directory in one getdents64 call
+#define GLOB_BUFFER_SIZE (256 * 1024)
+
+//state of the evaluation of a $((...)) expression
+struct arithmetic {
+    struct interpreter *interpreter; //frame the expression is evaluated in, for the arguments of a function
+    const char *text; //expression, terminated by \0
+    int position; //position of the next character to read
+    int error; //1 once an error has been printed, the rest of the expression is not evaluated
+    int skip; //greater than 0 inside a branch of &&, || or ?: which is not taken, no variables are changed
+};
+
+//binary operators of $((...)) with their precedence, a higher precedence binds tighter
+//longer operators come first so that they are matched first
+struct arithmetic_operator {
+    const char *text;
+    int length;
+    int precedence;
+};
+
+#define NUM_ARITHMETIC_OPERATORS 18
+
+const struct arithmetic_operator ARITHMETIC_OPERATORS[NUM_ARITHMETIC_OPERATORS] = {
+        {"||", 2, 1},
+        {"&&", 2, 2},
+        {"==", 2, 6},
+        {"!=", 2, 6},
+        {"<=", 2, 7},
+        {">=", 2, 7},
+        {"<<", 2, 8},
+        {">>", 2, 8},
+        {"|", 1, 3},
+        {"^", 1, 4},
+        {"&", 1, 5},
+        {"<", 1, 7},
+        {">", 1, 7},
+        {"+", 1, 9},
+        {"-", 1, 9},
+        {"*", 1, 10},
+        {"/", 1, 10},
+        {"%", 1, 10}
+};
+
+//operators recognised by the lexer, longer operators come first so that they are matched first
+struct operator {
+    const char *text;
+    int length;
+    enum token_type type;
+};
+
+const struct operator OPERATORS[] = {
+        {"<<<", 3, TOKEN_HERE_STRING},
+        {"&>>", 3, TOKEN_APPEND_ALL},
+        {"<<",  2, TOKEN_HERE_DOCUMENT},
+        {"&&",  2, TOKEN_AND},
+        {"||",  2, TOKEN_OR},
+        {">>",  2, TOKEN_REDIRECT_APPEND},
+        {"&>",  2, TOKEN_OUT_ALL},
+        {">&",  2, TOKEN_DUP_OUT},
+        {"<&",  2, TOKEN_DUP_IN},
+        {"<>",  2, TOKEN_READ_WRITE},
+        {";",   1, TOKEN_SEMICOLON},
+        {"&",   1, TOKEN_BACKGROUND},
+        {"|",   1, TOKEN_PIPE},
+        {">",   1, TOKEN_REDIRECT_OUT},
+        {"<",   1, TOKEN_REDIRECT_IN}
+};
+
+#define NUM_OPERATORS ((int) (sizeof(OPERATORS) / sizeof(OPERATORS[0])))
+
+//types of the nodes in the syntax tree of an input line
+enum node_type {
+    NODE_COMMAND, //a single command
+    NODE_PIPE, //'a | b'
+    NODE_SEQUENCE, //'a ; b' or 'a & b'
+    NODE_AND, //'a && b'
+    NODE_OR, //'a || b'
+    NODE_IF, //'if a; then b; else c; fi', an 'elif' is another if node after the else
+    NODE_WHILE, //'while a; do b; done'
+    NODE_FOR, //'for NAME in words; do b; done'
+    NODE_FUNCTION //'NAME() { b; }', which defines a function
+};
+
+//redirection of a command such as '2> file' or '2>&1', kept in the order it was written
+struct redirection {
+    enum token_type type; //redirection operator
+    int fd; //file descriptor written before the operator, -1 if the default one is used
+    struct token *target; //file name, file descriptor, or body of a here-document
+    struct redirection *next;
+};
+
+//node of the syntax tree which is built once for each input line
+struct node {
+    enum node_type type;
+    struct node *left; //first part of a pipe, sequence, '&&' or '||', or the condition of an if or while
+    struct node *right; //second part of a pipe, sequence, '&&' or '||', or the body of an if or loop
+    struct node *else_branch; //commands after the 'else' or 'elif' of an if, NULL if there are none
+    char *name; //variable set by a for loop, or the name of a function
+    struct token *tokens; //tokens of a command as they were written including any redirections, or the body of a function
+    int token_count; //number of tokens of a command or of the body of a function
+    struct token *words; //words of a command without the redirections, or the words after the 'in' of a for loop
+    int word_count; //number of words of a command
+    struct redirection *redirections; //redirections of a command, NULL if there are none
+    int background; //1 if the command or pipeline is followed by '&'
+    int timed; //1 if the command or pipeline is prefixed by 'time'
+};
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT 16
+
+//block of memory in the line arena, blocks are kept in a chain and reused for the next lines
+struct arena_block {
+    struct arena_block *next;
+    size_t size; //number of bytes in data
+    size_t used; //number of bytes already allocated from data
+    char data[];
+};
+
+//arena which the tokens, syntax tree, expanded words and arguments of a line are allocated from
+//everything is freed at once by moving back to a mark, so nothing has to be cleared byte by byte
+struct arena {
+    struct arena_block *first;
+    struct arena_block *current; //block which is being allocated from
+    void *last; //last allocation, which can be grown in place
+    size_t block_size; //smallest size of a new block
+};
+
+//position in the arena which can be moved back to, marks are taken and released like a stack
+struct arena_mark {
+    struct arena_block *block;
+    size_t used;
+};
+
+struct arena LINE_ARENA = {NULL, NULL, NULL, ARENA_BLOCK_SIZE};
+
+#define FUNCTION_BLOCK_SIZE 4096
+#define MAX_CALL_DEPTH 1000
+
+//deepest nesting of 'source', a script which sources itself is stopped before the C stack runs out
+#define MAX_SOURCE_DEPTH 1000
+
+//function defined with 'NAME() { ... }'
+//the tokens of the body are copied into an arena of the function, and parsed into a tree which is kept until it is defined again
+struct function {
+    struct function *next;
+    unsigned int hash;
+    struct node *body;
+    struct arena arena; //memory of the copied tokens and the tree of the body
+    int calls; //number of calls which are running, the body is only freed once there are none
+    int replaced; //1 if the function was defined again while it was running
+    int checking; //1 while substitution_runs_in_shell looks at the body, so a recursive function is looked at once
+    char name[];
+};
+
+struct function *FUNCTIONS = NULL;
+
+//state of one run of the interpreter, which is passed to everything that runs commands
+//'source', function calls and $(...) each run in a frame of their own on the C stack, which points to the frame
+//which started it, so they can be nested to any depth and nothing is left behind in globals when they finish
+struct interpreter {
+    struct interpreter *parent; //frame which started this one, NULL for the first frame
+    char **args; //expanded words of the command being run, allocated from the line arena
+    int arg_count; //number of words in args
+    struct word_source *print_words; //words of the running 'print', printed as they are produced
+    struct script_reader *reader; //script 'source' reads lines from, NULL for the terminal
+    int source_depth; //number of sourced scripts which are running
+    char **positional; //name and arguments of the function or script being run, used for $0 to $N, NULL if there are none
+    int positional_count;
+    int call_depth; //number of function calls which are running
+    int returning; //set by 'return' until the function or sourced script of this frame has stopped
+    int expansion_failed; //set when a $((...)) cannot be evaluated, so the command it is in is not run
+};
+
+int run_batch(int argc, char **argv);
 
-//array that stores the internal commands
-char INTERNAL_COMMANDS[NUM_INTERNAL_COMMANDS][MAX_LENGTH];
+void eggsh_init();
 
-//tokenised input arguments
-char *ARGS[MAX_LENGTH];
+void welcome_message();
 
-//number of input arguments
-int INPUT_ARGS_COUNT = 0;
+void print_header();
 
-//number of user created variables
-int VAR_COUNT = 0;
+void get_input_from_terminal(struct interpreter *interpreter);
 
-//number of times source has been called in source
-int SOURCE_DEPTH = 0;
+void get_input_from_file(struct interpreter *interpreter, const char filename[]);
 
-void eggsh_init();
+void start_interpreter_frame(struct interpreter *frame, struct interpreter *parent);
 
-void welcome_message();
+int execute_line(struct interpreter *interpreter, char line[]);
 
-void print_header();
+int read_here_documents(struct interpreter *interpreter, struct token_list *list, int start);
 
-void get_input_from_terminal();
+int read_continuation_line(struct interpreter *interpreter, struct token_list *list);
 
-void get_input_from_file(const char filename[]);
+char *read_here_document_line(struct interpreter *interpreter);
 
-int check_for_char_in_string(const char input[], int input_length, char check_char);
+int open_script_reader(struct script_reader *reader, const char filename[]);
 
-int check_var_name_validity(const char input[], int input_length);
+void open_script_stream(struct script_reader *reader, int fd);
 
-int check_user_variable_names(const char var_name[]);
+void open_script_text(struct script_reader *reader, const char text[]);
 
-void set_variable(const char input[], int input_length, int equals_position);
+int execute_script(struct interpreter *interpreter);
 
-char *get_variable_value(const char var_name[]);
+char *next_script_line(struct script_reader *reader);
 
-char *get_value_after_dollar(char input[], int input_length);
+void release_script_blocks(struct script_reader *reader);
 
-void clear_string(char input[], int input_length);
+void close_script_reader(struct script_reader *reader);
 
-void print_standard_variables();
+struct node *parse_list(struct token tokens[], int token_count, int *position);
 
-void print_user_variables();
+struct node *parse_and_or(struct token tokens[], int token_count, int *position);
 
-int tokenise_input(char input[]);
+struct node *parse_pipeline(struct token tokens[], int token_count, int *position);
 
-void clear_and_null_args();
+struct node *parse_command(struct token tokens[], int token_count, int *position);
 
-int check_internal_command(const char input[]);
+struct redirection **parse_redirection(struct token tokens[], int token_count, int *position,
+                                       struct redirection **last_redirection);
 
-int execute_internal_command(const char command[], int redirect);
+struct node *parse_compound_command(struct token tokens[], int token_count, int *position);
 
-void print_command();
+struct node *parse_if(struct token tokens[], int token_count, int *position);
 
-void change_directory(char path[]);
+struct node *parse_while(struct token tokens[], int token_count, int *position);
 
-void execute_external_command(const char command[], int redirect);
+struct node *parse_for(struct token tokens[], int token_count, int *position);
 
-int main(int argc, char **argv, char **env) {
+int expect_keyword(struct token tokens[], int token_count, int *position, const char keyword[]);
 
-    //clear any data in the terminal before starting
-    clear_terminal();
-    linenoiseClearScreen();
+int is_keyword(const struct token *token, const char keyword[]);
 
-    //set the history of linenoise
-    linenoiseHistorySetMaxLen(10);
+int is_compound_keyword(const struct token *token);
 
-    eggsh_init();
+int is_list_terminator(const struct token *token);
 
-    welcome_message();
+int is_separator(enum token_type type);
 
-    get_input_from_terminal();
+void print_syntax_error(struct token tokens[], int token_count, int position);
 
-    return 0;
-}
+struct node *new_node(enum node_type type, struct node *left, struct node *right);
 
-//function which initialises shell variables
-void eggsh_init() {
-    //get the HOME environmental variable
-    if (getenv("HOME") != NULL) {
-        char *temp_home = getenv("HOME");
-        strncpy(HOME, temp_home, strlen(temp_home));
-    } else {
-        perror("Cannot get HOME environment variable");
-    }
+int evaluate_node(struct interpreter *interpreter, struct node *node);
 
-    //get the USER environmental variable
-    if (getenv("USER") != NULL) {
-        char *temp_user = getenv("USER");
-        strncpy(USER, temp_user, strlen(temp_user));
-    } else {
-        perror("Cannot get USER environment variable");
-    }
+int execute_pipeline_node(struct interpreter *interpreter, struct node *node);
 
-    //get the SHELL environmental variable
-    if (getenv("SHELL") != NULL) {
-        char *temp_shell = getenv("SHELL");
-        strncpy(SHELL, temp_shell, strlen(temp_shell));
-    } else {
-        perror("Cannot get SHELL environment variable");
-    }
+int evaluate_compound_node(struct interpreter *interpreter, struct node *node);
 
-    //get the name of current terminal
-    if (ttyname_r(STDIN_FILENO, TERMINAL, MAX_LENGTH) != 0) {
-        perror("Cannot get terminal name.");
-    }
+int execute_if_node(struct interpreter *interpreter, struct node *node);
 
-    //get the current working directory
-    if (getcwd(CWD, sizeof(CWD)) == NULL) {
-        perror("Cannot get current working directory");
-    }
+int execute_while_node(struct interpreter *interpreter, struct node *node);
 
-    //get the search path for external commands
-    if (getenv("PATH") != NULL) {
-        char *temp_path = getenv("PATH");
-        strncpy(PATH, temp_path, strlen(temp_path));
-    }
+int execute_for_node(struct interpreter *interpreter, struct node *node);
 
-    //fill up the array with all the internal commands to check later on
-    //this array is used to allow for more commands in the future
-    strncpy(INTERNAL_COMMANDS[0], "exit", strlen("exit"));
-    strncpy(INTERNAL_COMMANDS[1], "print", strlen("print"));
-    strncpy(INTERNAL_COMMANDS[2], "chdir", strlen("chdir"));
-    strncpy(INTERNAL_COMMANDS[3], "all", strlen("all"));
-    strncpy(INTERNAL_COMMANDS[4], "source", strlen("source"));
+struct node *parse_function_definition(struct token tokens[], int token_count, int *position);
 
-    //set all the input arguments to null
-    for (int i = 0; i < MAX_LENGTH; i++) {
-        ARGS[i] = NULL;
-    }
-}
+int is_function_start(const struct token *token);
 
-//function that prints the header and a welcome message
-void welcome_message() {
-    print_header();
-    printf("Welcome %s!\n", USER);
-}
+void define_function(struct node *node);
 
-//function that prints a line a the title of the shell
-void print_header() {
-    //get the width of the terminal
-    struct winsize terminal_size;
-    ioctl(STDIN_FILENO, TIOCGWINSZ, &terminal_size);
+struct function *find_function(const char name[]);
 
-    //print dashed line
-    if (terminal_size.ws_col != 0) {
-        for (int i = 0; i < (terminal_size.ws_col - strlen(TERMINAL_TITLE)) / 2; i++) {
-            printf("-");
-        }
-    }
+void free_function(struct function *function);
 
-    //print terminal title
-    printf("%s", TERMINAL_TITLE);
+int call_function(struct interpreter *interpreter, struct function *function, const struct redirection_plan *plan);
 
-    //print dashed line
-    if (terminal_size.ws_col != 0) {
-        for (int i = 0; i < (terminal_size.ws_col - strlen(TERMINAL_TITLE)) / 2; i++) {
-            printf("-");
-        }
-    }
+int return_command(struct interpreter *interpreter);
 
-    printf("\n");
-}
+int exit_command(struct interpreter *interpreter);
 
-//function which gets the input from the terminal through linenoise
-//checks the input and executes the appropriate set of commands
-void get_input_from_terminal() {
-    char *input = "";
-    int input_length = 0;
+int is_positional_parameter(const char text[]);
 
-    fflush(STDIN_FILENO);
+const char *get_positional_parameter(struct interpreter *interpreter, const char text[], int *name_length);
 
-    //get input from terminal
-    while ((input = linenoise(PROMPT)) != NULL) {
+void free_arena(struct arena *arena);
 
-        //store the input in the linenoise history
-        linenoiseHistoryAdd(input);
+int execute_simple_command(struct interpreter *interpreter, struct node *node);
 
-        input_length = (int) strlen(input);
+int is_lazy_print(const struct node *node);
 
-        //checking for VAR=VALUE
-        int equals_position = check_for_char_in_string(input, input_length, '=');
-
-        //if VAR=VALUE, either set an existing variable or create a new one
-        if (equals_position != -1 && equals_position != 0) {
-            set_variable(input, input_length, equals_position);
-        } else if (strcasecmp(input, "") != 0) { //if the input is not VAR=VALUE, tokenise it
-            INPUT_ARGS_COUNT = tokenise_input(input);
-
-            int redirect_type = 0;
-
-            //check if the input contains any arguments for redirection
-            if (INPUT_ARGS_COUNT > 2) {
-                if (strcmp(ARGS[INPUT_ARGS_COUNT - 2], ">") == 0) {
-                    redirect_type = 1;
-                } else if (strcmp(ARGS[INPUT_ARGS_COUNT - 2], ">>") == 0) {
-                    redirect_type = 2;
-                } else if (strcmp(ARGS[1], "<") == 0) {
-                    redirect_type = 3;
-                } else if (strcmp(ARGS[1], "<<<") == 0) {
-                    redirect_type = 4;
-                }
-            }
+int is_redirection(enum token_type type);
 
-            char command[10 * MAX_LENGTH] = "";
+void set_exit_code(int exit_code);
 
-            //read input from file for input redirection
-            if (redirect_type == 3) {
-                char filename[MAX_LENGTH] = "";
-                strncpy(filename, ARGS[INPUT_ARGS_COUNT - 1], strlen(ARGS[INPUT_ARGS_COUNT - 1]));
+int check_for_char_in_string(const char input[], int input_length, char check_char);
 
-                FILE *openFile;
-                int file_length = 0;
-                char line[MAX_LENGTH] = "";
-                char file[10 * MAX_LENGTH] = "";
+int check_var_name_validity(const char input[], int input_length);
 
-                //open the file in read only mode
-                if ((openFile = fopen(filename, "r")) == NULL) {
-                    perror("Cannot open file");
-                } else {
-                    while (fgets(line, sizeof(line), openFile) != NULL) {
-                        if (line[(int) strlen(line) - 1] == '\n') {
-                            line[(int) strlen(line) - 1] = ' ';
-                        }
-                        strcat(file, line);
-                        clear_string(line, (int) strlen(line));
-                    }
+struct variable *find_variable(const char name[], size_t length);
 
-                    file_length = (int) strlen(file);
-                    if (file[file_length - 1] == ' ' || file[file_length - 1] == '\n') {
-                        file[file_length - 1] = '\0';
-                    }
+struct variable *add_variable(const char name[], size_t length, int flags);
 
-                    sprintf(command, "%s %s", ARGS[0], file);
+void store_variable_value(struct variable *variable, const char value[]);
 
-                    clear_and_null_args();
+char *variable_value(struct variable *variable);
 
-                    INPUT_ARGS_COUNT = tokenise_input(command);
+int set_variable_value(struct variable *variable, const char value[]);
 
-                    fclose(openFile);
+int get_variable_integer(struct variable *variable, long long *value);
 
-                    clear_string(filename, (int) strlen(filename));
-                    clear_string(file, file_length);
-                }
-            } else if (redirect_type == 4) { //read input from here string for input redirection
-                if (INPUT_ARGS_COUNT == 3) {
-                    //shift the arguments over by one and null the last one
-                    //remove any ' from the string
-                    clear_string(ARGS[1], (int) strlen(ARGS[1]));
-                    ARGS[1] = ARGS[2];
-                    ARGS[2] = NULL;
-                    INPUT_ARGS_COUNT--;
-                    strncpy(ARGS[1], &ARGS[1][1], strlen(ARGS[1]));
-                    ARGS[1][(int) strlen(ARGS[1])] = '\0';
-                    ARGS[1][(int) strlen(ARGS[1]) - 1] = '\0';
-                } else if (INPUT_ARGS_COUNT > 3) {
-                    //shift the arguments over by one and null the last one
-                    //remove any ' from the first string and last string
-                    clear_string(ARGS[1], (int) strlen(ARGS[1]));
-                    for (int i = 1; i < INPUT_ARGS_COUNT - 1; i++) {
-                        ARGS[i] = ARGS[i + 1];
-                    }
+int set_variable_integer(struct variable *variable, long long value);
 
-                    INPUT_ARGS_COUNT--;
+struct variable *add_shell_variable(const char name[], char **global, const char value[], int flags,
+                                    int (*on_set)(const char value[]));
 
-                    if (ARGS[1][0] == '\'') {
-                        strncpy(ARGS[1], &ARGS[1][1], strlen(ARGS[1]));
-                        ARGS[1][(int) strlen(ARGS[1])] = '\0';
-                    }
+void add_computed_variable(const char name[], char **global, int (*on_set)(const char value[]),
+                           void (*on_get)(struct variable *variable));
 
-                    if (ARGS[INPUT_ARGS_COUNT - 1][(int) strlen(ARGS[INPUT_ARGS_COUNT - 1]) - 1] == '\'') {
-                        ARGS[INPUT_ARGS_COUNT - 1][(int) strlen(ARGS[INPUT_ARGS_COUNT - 1]) - 1] = '\0';
-                    }
-                }
-            }
+void add_readonly_variable(const char name[], char value[]);
 
-            //check for internal commands
-            int command_position = check_internal_command(ARGS[0]);
+void import_environment();
 
-            if (command_position != -1) {
-                //check if 'exit' is entered
-                if (execute_internal_command(ARGS[0], redirect_type) == 1) {
-                    break;
-                }
-            } else { //if it is not an internal command, then it must be an external command
-                execute_external_command(ARGS[0], redirect_type);
-            }
+void export_variable(struct variable *variable);
 
-            //clear and null all the input arguments to that the array can be refilled
-            clear_and_null_args();
-            clear_string(command, (int) strlen(command));
-        }
+void update_environment_entry(struct variable *variable);
 
-        //clear the input so that it can be refilled
-        clear_string(input, input_length);
+void remove_environment_entry(struct variable *variable);
 
-        //free the allocated linenoise input
-        linenoiseFree(input);
-    }
-}
+void remove_variable(struct variable *variable);
 
-//this function is very similar to previous one but instead of getting
-//input from linoise, the input is received from a file when 'source' is executed
-void get_input_from_file(const char filename[]) {
-    FILE *openFile;
-    int line_length = 0;
-    char line[MAX_LENGTH];
+int export_command(struct interpreter *interpreter);
 
-    //open the file in read only mode
-    if ((openFile = fopen(filename, "r")) == NULL) {
-        perror("Cannot open file");
-    } else {
-        clear_and_null_args();
-        //if a source is run in a source, this will get incremented
-        SOURCE_DEPTH++;
-
-        //get inputs from the file line by line
-        while (fgets(line, sizeof(line), openFile) != NULL) {
-            line_length = (int) strlen(line);
-
-            //remove \n from the end of the line
-            if (line[line_length - 1] == '\n') {
-                line[line_length - 1] = '\0';
-            }
-
-            //checking for VAR=VALUE
-            int equals_position = check_for_char_in_string(line, line_length, '=');
-
-            //if VAR=VALUE, either set an existing variable or create a new one
-            if (equals_position != -1 && equals_position != 0) {
-                set_variable(line, line_length, equals_position);
-            } else if (strcasecmp(line, "") != 0) { //if the input is not VAR=VALUE, tokenise it
-                INPUT_ARGS_COUNT = tokenise_input(line);
-
-                //code to handle redirection inside source, still buggy
-                int redirect_type = 0;
-
-                /*if (INPUT_ARGS_COUNT > 2) {
-                    if (strcmp(ARGS[INPUT_ARGS_COUNT - 2], ">") == 0) {
-                        redirect_type = 1;
-                    } else if (strcmp(ARGS[INPUT_ARGS_COUNT - 2], ">>") == 0) {
-                        redirect_type = 2;
-                    } else if (strcmp(ARGS[1], "<") == 0) {
-                        redirect_type = 3;
-                    } else if (strcmp(ARGS[1], "<<<") == 0) {
-                        redirect_type = 4;
-                    }
-                }
+int unset_command(struct interpreter *interpreter);
 
-                char command[10 * MAX_LENGTH] = "";
+int on_set_path(const char value[]);
 
-                if (redirect_type == 3) {
-                    char redirect_filename[MAX_LENGTH] = "";
-                    strncpy(redirect_filename, ARGS[INPUT_ARGS_COUNT - 1], strlen(ARGS[INPUT_ARGS_COUNT - 1]));
+int on_set_cwd(const char value[]);
 
-                    FILE *redirectFile;
-                    int file_length = 0;
-                    char redirect_line[MAX_LENGTH] = "";
-                    char file[10 * MAX_LENGTH] = "";
+void get_cwd_value(struct variable *variable);
 
-                    if ((redirectFile = fopen(redirect_filename, "r")) == NULL) {
-                        perror("Cannot open file");
-                    } else {
-                        while (fgets(redirect_line, sizeof(redirect_line), redirectFile) != NULL) {
-                            if (line[(int)strlen(line) - 1] == '\n'){
-                                line[(int)strlen(line) - 1] = ' ';
-                            }
-                            strcat(file, redirect_line);
-                            clear_string(redirect_line, (int) strlen(redirect_line));
-                        }
+void invalidate_cwd();
 
-                        file_length = (int) strlen(file);
-                        if (file[file_length - 1] == ' ' || file[file_length - 1] == '\n'){
-                            file[file_length - 1] = '\0';
-                        }
+void get_terminal_value(struct variable *variable);
 
-                        sprintf(command, "%s %s", ARGS[0], file);
+void set_variable(const char input[], int input_length, int equals_position);
 
-                        clear_and_null_args();
+char *get_variable_value(const char var_name[]);
 
-                        INPUT_ARGS_COUNT = tokenise_input(command);
+void clear_string(char input[], int input_length);
 
-                        fclose(redirectFile);
+void print_standard_variables();
 
-                        clear_string(redirect_filename, (int) strlen(redirect_filename));
-                        clear_string(file, file_length);
-                    }
-                } else if (redirect_type == 4) {
-                    if (INPUT_ARGS_COUNT == 3) {
-                        clear_string(ARGS[1], (int) strlen(ARGS[1]));
-                        ARGS[1] = ARGS[2];
-                        ARGS[2] = NULL;
-                        INPUT_ARGS_COUNT--;
-                        strncpy(ARGS[1], &ARGS[1][1], strlen(ARGS[1]));
-                        ARGS[1][(int) strlen(ARGS[1])] = '\0';
-                        ARGS[1][(int) strlen(ARGS[1]) - 1] = '\0';
-                    } else if (INPUT_ARGS_COUNT > 3) {
-                        clear_string(ARGS[1], (int) strlen(ARGS[1]));
-                        for (int i = 1; i < INPUT_ARGS_COUNT - 1; i++) {
-                            ARGS[i] = ARGS[i + 1];
-                        }
+void print_user_variables();
 
-                        INPUT_ARGS_COUNT = INPUT_ARGS_COUNT - 1;
+void *arena_alloc(size_t size);
 
-                        if (ARGS[1][0] == '\'') {
-                            strncpy(ARGS[1], &ARGS[1][1], strlen(ARGS[1]));
-                            ARGS[1][(int) strlen(ARGS[1])] = '\0';
-                        }
+void *arena_grow(void *pointer, size_t old_size, size_t new_size);
 
-                        if (ARGS[INPUT_ARGS_COUNT - 1][(int) strlen(ARGS[INPUT_ARGS_COUNT - 1]) - 1] == '\'') {
-                            ARGS[INPUT_ARGS_COUNT - 1][(int) strlen(ARGS[INPUT_ARGS_COUNT - 1]) - 1] = '\0';
-                        }
-                    }
-                }*/
+char *arena_strndup(const char input[], size_t length);
 
-                //check for internal commands
-                int command_position = check_internal_command(ARGS[0]);
+struct arena_mark arena_get_mark();
 
-                if (command_position != -1) {
-                    //check if 'exit' is entered
-                    if (execute_internal_command(ARGS[0], redirect_type) == 1) {
-                        break;
-                    }
-                } else { //if it is not an internal command, then it must be an external command
-                    execute_external_command(ARGS[0], redirect_type);
-                }
+void arena_release(struct arena_mark mark);
 
-                //this is to check for when a source is run from a source
-                if (SOURCE_DEPTH == 2) {
-                    clear_and_null_args();
-                }
+int tokenise_input(char input[], struct token_list *list);
 
-                //clear_string(command, (int) strlen(command));
-            }
+const struct operator *match_operator(const char input[]);
 
-            clear_string(line, line_length);
-        }
+void add_token(struct token_list *list, enum token_type type, char *text, int length, int flags);
 
-        //if a source has finished executing in a source, this will get decremented
-        SOURCE_DEPTH--;
+char *expand_word(struct interpreter *interpreter, const struct token *token);
 
-        //close the file to avoid any problems
-        fclose(openFile);
-    }
-}
+char *expand_word_text(struct interpreter *interpreter, const struct token *token, int glob_pattern);
 
-//function to check if the input contains an a certain character
-//returns a -1 if no character is found, else returns the position of the character
-int check_for_char_in_string(const char input[], int input_length, char check_char) {
-    int char_position = -1;
+char **expand_glob(const char pattern[], int *match_count);
 
-    for (int i = 0; i < input_length; i++) {
-        if (input[i] == check_char) {
-            char_position = i;
-            break;
-        }
-    }
+struct glob_directory *read_glob_directory(const char path[]);
 
-    return char_position;
-}
+void compile_glob_pattern(const char component[], size_t length, struct glob_pattern *pattern);
 
-//function to check whether a user created variable is valid
-//returns 0 if invalid and 1 if valid
-int check_var_name_validity(const char input[], int input_length) {
-    int valid = 1;
+int match_glob_pattern(const struct glob_pattern *pattern, const char name[]);
 
-    for (int i = 0; i < input_length; i++) {
-        if (input[i] >= 48 && input[i] <= 57) {
-            valid = 1;
-        } else if (input[i] >= 65 && input[i] <= 90) {
-            valid = 1;
-        } else if (input[i] >= 97 && input[i] <= 122) {
-            valid = 1;
-        } else if (input[i] == '_') {
-            valid = 1;
-        } else {
-            valid = 0;
-            break;
-        }
-    }
+int glob_element_matches(const struct glob_element *element, unsigned char character);
 
-    return valid;
-}
+char *unescape_glob_pattern(const char pattern[], size_t length);
 
-//function which checks the array of user added variables to see if a variable exists
-//if the variable exists return the position of that variable, else return -1
-int check_user_variable_names(const char var_name[]) {
-    int var_position = -1;
+void sort_paths(char *paths[], int count);
 
-    for (int i = 0; i < VAR_COUNT; i++) {
-        if (strcasecmp(var_name, USER_VAR_NAMES[i]) == 0) {
-            var_position = i;
-            break;
-        }
-    }
+int compare_sort_keys(const void *first, const void *second);
 
-    return var_position;
-}
+int find_substitution_end(const char input[], int start);
 
-//function which edits a current variable ot adds a user created
-//variable if VAR=VALUE is entered
-void set_variable(const char input[], int input_length, int equals_position) {
-    char temp_var_name[MAX_LENGTH] = {0};
-    strncpy(temp_var_name, input, (size_t) equals_position);
+char *command_substitution(struct interpreter *interpreter, const char command[], size_t length, size_t *output_length);
 
-    //check if the variable name is valid
-    if (check_var_name_validity(temp_var_name, (int) strlen(temp_var_name)) == 0) {
-        printf("Invalid variable name.\n");
-        return;
-    }
+int substitution_runs_in_shell(struct node *node);
 
-    //check if the value of the variable is left empty
-    if (equals_position == input_length - 1) {
-        printf("Invalid variable value.\n");
-        return;
-    }
+char *arithmetic_expansion(struct interpreter *interpreter, const char expression[], size_t length,
+                           size_t *output_length);
 
-    char temp_var_value[MAX_LENGTH] = {0};
-    strncpy(temp_var_value, &input[equals_position + 1], (size_t) (input_length - (equals_position + 1)));
+long long evaluate_arithmetic_assignment(struct arithmetic *state);
 
-    //check if the $ is used
-    int dollar_position = check_for_char_in_string(input, input_length, '$');
+long long evaluate_arithmetic_binary(struct arithmetic *state, int min_precedence);
 
-    //if the string contains a $ after the =, get the value determined by the variable name after the $
-    if (dollar_position == (equals_position + 1)) {
-        char var_with_dollar[MAX_LENGTH] = {0};
-        strncpy(var_with_dollar, temp_var_value, strlen(temp_var_value));
+long long evaluate_arithmetic_unary(struct arithmetic *state);
 
-        clear_string(temp_var_value, MAX_LENGTH);
+long long apply_arithmetic_operator(struct arithmetic *state, const char operator[], long long left, long long right);
 
-        strcpy(temp_var_value, get_value_after_dollar(var_with_dollar, (int) strlen(var_with_dollar)));
-    }
+int read_arithmetic_name(struct arithmetic *state, struct variable **variable);
 
-    //checking whether a variable already exists as a shell variable
-    //if the variable already exists as a shell variable, update the the value
-    if (strcmp(temp_var_name, "PATH") == 0) {
-        if (setenv("PATH", temp_var_value, 1) != 0) {
-            perror("Cannot set variable PATH");
-        } else {
-            clear_string(PATH, (int) strlen(PATH));
-            strncpy(PATH, temp_var_value, strlen(temp_var_value));
-        }
-    } else if (strcmp(temp_var_name, "PROMPT") == 0) {
-        clear_string(PROMPT, (int) strlen(PROMPT));
-        strncpy(PROMPT, temp_var_value, strlen(temp_var_value));
-    } else if (strcmp(temp_var_name, "CWD") == 0) {
-        if (chdir(temp_var_value) != 0) {
-            perror("Cannot change directory");
-        } else {
-            clear_string(CWD, (int) strlen(CWD));
-            strncpy(CWD, temp_var_value, strlen(temp_var_value));
-        }
-    } else if (strcmp(temp_var_name, "USER") == 0) {
-        if (setenv("USER", temp_var_value, 1) != 0) {
-            perror("Cannot set variable USER");
-        } else {
-            clear_string(USER, (int) strlen(USER));
-            strncpy(USER, temp_var_value, strlen(temp_var_value));
-        }
-    } else if (strcmp(temp_var_name, "HOME") == 0) {
-        if (setenv("HOME", temp_var_value, 1) != 0) {
-            perror("Cannot set variable HOME");
-        } else {
-            clear_string(HOME, (int) strlen(HOME));
-            strncpy(HOME, temp_var_value, strlen(temp_var_value));
-        }
-    } else if (strcmp(temp_var_name, "SHELL") == 0) {
-        if (setenv("SHELL", temp_var_value, 1) != 0) {
-            perror("Cannot set variable SHELL");
-        } else {
-            clear_string(SHELL, (int) strlen(SHELL));
-            strncpy(SHELL, temp_var_value, strlen(temp_var_value));
-        }
-    } else if (strcmp(temp_var_name, "TERMINAL") == 0) {
-        clear_string(TERMINAL, (int) strlen(TERMINAL));
-        strncpy(TERMINAL, temp_var_value, strlen(temp_var_value));
-    } else {
-        //if the variable name is not a shell variable, check if it is a user added variable
-        int var_position = check_user_variable_names(temp_var_name);
+void skip_arithmetic_spaces(struct arithmetic *state);
 
-        if (var_position != -1) { //if the variable already exists as a user added variable, update the the value
-            clear_string(USER_VAR_VALUES[var_position], MAX_LENGTH);
-            strncpy(USER_VAR_VALUES[var_position], temp_var_value, strlen(temp_var_value));
-        } else { //if the variable does not exist, add a new variable
-            strncpy(USER_VAR_NAMES[VAR_COUNT], temp_var_name, strlen(temp_var_name));
-            strncpy(USER_VAR_VALUES[VAR_COUNT], temp_var_value, strlen(temp_var_value));
-            VAR_COUNT++;
-        }
-        setenv(temp_var_name, temp_var_value, 1);
-    }
-}
+void arithmetic_error(struct arithmetic *state, const char message[]);
 
-//function which takes a string as an input and checks
-//if that string is a variable which has a corresponding value
-//if the variable name is found, its value is returned
-char *get_variable_value(const char var_name[]) {
-    int var_position = -1;
-
-    if (strcmp(var_name, "PATH") == 0) {
-        return PATH;
-    } else if (strcmp(var_name, "PROMPT") == 0) {
-        return PROMPT;
-    } else if (strcmp(var_name, "CWD") == 0) {
-        return CWD;
-    } else if (strcmp(var_name, "USER") == 0) {
-        return USER;
-    } else if (strcmp(var_name, "HOME") == 0) {
-        return HOME;
-    } else if (strcmp(var_name, "SHELL") == 0) {
-        return SHELL;
-    } else if (strcmp(var_name, "TERMINAL") == 0) {
-        return TERMINAL;
-    } else if (strcmp(var_name, "EXITCODE") == 0) {
-        sprintf(EXITCODE_S, "%d", EXITCODE);
-        return EXITCODE_S;
-    } else {
-        for (int i = 0; i < VAR_COUNT; i++) {
-            if (strcmp(USER_VAR_NAMES[i], var_name) == 0) {
-                var_position = i;
-                break;
-            }
-        }
+int expand_tokens(struct interpreter *interpreter, const struct token tokens[], int token_count);
 
-        if (var_position != -1) {
-            return USER_VAR_VALUES[var_position];
-        } else {
-            return "";
-        }
-    }
-}
+void start_word_source(struct interpreter *interpreter, struct word_source *source, const struct token tokens[],
+                       int token_count);
 
-//function which returns the value of the variable when the input received is '$VAR'
-char *get_value_after_dollar(char input[], int input_length) {
-    char var_after_dollar[MAX_LENGTH] = {0};
+char *next_word(struct word_source *source);
 
-    strncpy(var_after_dollar, &input[1], (size_t) (input_length - 1));
+char *next_glob_match(struct word_source *source, const struct token *token);
 
-    if (strcmp(get_variable_value(var_after_dollar), "") == 0) {
-        return input;
-    } else {
-        return get_variable_value(var_after_dollar);
-    }
-}
+size_t get_environment_size();
 
-//function which clears the given string
-void clear_string(char input[], int input_length) {
-    if (input_length > 0) {
-        for (int i = 0; i < input_length; i++) {
-            input[i] = '\0';
-        }
-    }
-}
+struct brace_expansion *parse_brace_expansion(const char text[], int length);
 
-//function which prints all the standard variables
-void print_standard_variables() {
-    printf("PATH=%s\n", PATH);
-    printf("PROMPT=%s\n", PROMPT);
-    printf("CWD=%s\n", CWD);
-    printf("USER=%s\n", USER);
-    printf("HOME=%s\n", HOME);
-    printf("SHELL=%s\n", SHELL);
-    printf("TERMINAL=%s\n", TERMINAL);
-    printf("EXITCODE=%s\n", EXITCODE_S);
-}
+int find_brace_end(const char text[], int start, int length);
 
-//function which prints all the user created variables
-void print_user_variables() {
-    if (VAR_COUNT != 0) {
-        for (int i = 0; i < VAR_COUNT; i++) {
-            printf("%s=%s \n", USER_VAR_NAMES[i], USER_VAR_VALUES[i]);
-        }
-    }
-}
+int parse_brace_range(const char text[], int length, struct brace_part *part);
 
-//functions which gets an input string, tokenises it and fills the global ARGS array
-//the function returns the number of input arguments
-int tokenise_input(char input[]) {
-    char *token;
-    int token_index = 0;
+void reset_brace_expansion(struct brace_expansion *expansion);
 
-    //get first token
-    token = strtok(input, " ");
+int advance_brace_expansion(struct brace_expansion *expansion);
 
-    //tokenise the rest of the string
-    while (token != NULL && token_index < MAX_LENGTH) {
-        ARGS[token_index] = token;
-        token_index++;
-        token = strtok(NULL, " ");
-    }
+size_t write_brace_word(const struct brace_expansion *expansion, struct word_source *source, size_t length);
 
-    return token_index;
-}
+void clear_and_null_args(struct interpreter *interpreter);
 
-//function which clears all the input arguments and sets the pointers to null
-void clear_and_null_args() {
-    if (INPUT_ARGS_COUNT > 0) {
-        for (int i = 0; i < INPUT_ARGS_COUNT; i++) {
-            clear_string(ARGS[i], (int) strlen(ARGS[i]));
-        }
+int check_internal_command(const char input[]);
 
-        for (int i = 0; i < MAX_LENGTH; i++) {
-            ARGS[i] = NULL;
-        }
-    }
-}
+int execute_command(struct interpreter *interpreter, const struct redirection_plan *plan);
 
-//function which checks whether the first argument in the input is an internal command
-//returns -1 if the command is not found, returns a value greater or equal to 0 if it is found
-int check_internal_command(const char input[]) {
-    int command_position = -1;
+int execute_timed_command(struct interpreter *interpreter, struct node *node);
 
-    for (int i = 0; i < NUM_INTERNAL_COMMANDS; i++) {
-        if (strcasecmp(input, INTERNAL_COMMANDS[i]) == 0) {
-            command_position = i;
-            break;
-        }
-    }
+int execute_internal_command(struct interpreter *interpreter, const char command[],
+                             const struct redirection_plan *plan);
 
-    return command_position;
-}
+int prepare_redirections(struct interpreter *interpreter, struct redirection *redirections,
+                         struct redirection_plan *plan);
 
-//function which executes an internal command depending on the first argument
-//the function also take care of output redirection
-//returns 1 is 'exit' is entered, returns 0 otherwise
-int execute_internal_command(const char command[], int redirect) {
-    int exit_terminal = 0;
+int parse_fd_number(const char input[]);
 
-    //check which internal command is called
-    if (strcasecmp(command, "exit") == 0) {
-        exit_terminal = 1;
-    } else if (strcasecmp(command, "print") == 0) {
-        if (INPUT_ARGS_COUNT == 1) {
-            printf("Invalid input!\n");
-            return 0;
-        }
+void close_redirection_files(const struct redirection_plan *plan);
 
-        //if the '>' redirection argument is used, redirect the output to the file
-        if (redirect == 1) {
-            //get the input file name and remove the last two input arguments
-            char filename[MAX_LENGTH];
-            strncpy(filename, ARGS[INPUT_ARGS_COUNT - 1], strlen(ARGS[INPUT_ARGS_COUNT - 1]));
+struct fd_action *apply_redirections_in_shell(const struct redirection_plan *plan);
 
-            clear_string(ARGS[INPUT_ARGS_COUNT - 1], (int) strlen(ARGS[INPUT_ARGS_COUNT - 1]));
-            clear_string(ARGS[INPUT_ARGS_COUNT - 2], (int) strlen(ARGS[INPUT_ARGS_COUNT - 2]));
-            ARGS[INPUT_ARGS_COUNT - 1] = NULL;
-            ARGS[INPUT_ARGS_COUNT - 2] = NULL;
+void restore_redirections_in_shell(struct fd_action saved_fds[], int count);
 
-            INPUT_ARGS_COUNT = INPUT_ARGS_COUNT - 2;
+int apply_redirections_in_child(const struct redirection_plan *plan);
 
-            //fork the main branch to be able to redirect the output smoothly
-            pid_t pid = fork();
+int args_command(struct interpreter *interpreter);
 
-            if (pid < 0) {
-                perror("Unable to fork");
-                exit(EXIT_FAILURE);
-            } else if (pid == 0) {
-                //open the file in read-write-truncate mode and create it if it is not found
-                int fd = open(filename, O_RDWR | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR | S_IXUSR);
-                if (fd > 0) {
-                    //redirect STDOUT to the file
-                    dup2(fd, 1);
-                    //execute the print command
-                    print_command();
-                    //close the file
-                    close(fd);
-                    exit(EXIT_SUCCESS);
-                } else {
-                    perror("Unable to open file");
-                    exit(EXIT_FAILURE);
-                }
-            }
+void print_command(struct interpreter *interpreter);
 
-            wait(NULL);
-        } else if (redirect == 2) { //if the '>>' redirection argument is used, redirect the output to the file
-            //get the input file name and remove the last two input arguments
-            char filename[MAX_LENGTH];
-            strncpy(filename, ARGS[INPUT_ARGS_COUNT - 1], strlen(ARGS[INPUT_ARGS_COUNT - 1]));
+int change_directory(char path[]);
 
-            clear_string(ARGS[INPUT_ARGS_COUNT - 1], (int) strlen(ARGS[INPUT_ARGS_COUNT - 1]));
-            clear_string(ARGS[INPUT_ARGS_COUNT - 2], (int) strlen(ARGS[INPUT_ARGS_COUNT - 2]));
-            ARGS[INPUT_ARGS_COUNT - 1] = NULL;
-            ARGS[INPUT_ARGS_COUNT - 2] = NULL;
+void execute_external_command(struct interpreter *interpreter, const struct redirection_plan *plan);
 
-            INPUT_ARGS_COUNT = INPUT_ARGS_COUNT - 2;
+int open_here_document(const char body[], size_t length);
 
-            //fork the main branch to be able to redirect the output smoothly
-            pid_t pid = fork();
+pid_t launch_external_command(char *argv[], const struct launch_options *options);
 
-            if (pid < 0) {
-                perror("Unable to fork");
-                exit(EXIT_FAILURE);
-            } else if (pid == 0) {
-                //open the file in read-write-append mode
-                int fd = open(filename, O_RDWR | O_APPEND, S_IRUSR | S_IWUSR | S_IXUSR);
-                if (fd > 0) {
-                    //redirect STDOUT to the file
-                    dup2(fd, 1);
-                    //execute the print command
-                    print_command();
-                    //close the file
-                    close(fd);
-                    exit(EXIT_SUCCESS);
-                } else {
-                    perror("Unable to open file");
-                    exit(EXIT_FAILURE);
-                }
+int launch_failure_status(int error);
+
+int wait_status_to_exit_code(int wait_val);
+
+pid_t spawn_external_command(const char path[], char *argv[], const struct launch_options *options);
+
+pid_t fork_with_options(const struct launch_options *options);
+
+pid_t fork_external_command(const char path[], char *argv[], const struct launch_options *options);
+
+pid_t fork_internal_command(struct interpreter *interpreter, char *argv[], const struct launch_options *options);
+
+void close_cloexec_fds();
+
+void give_terminal_to(pid_t pgid);
+
+void execute_pipeline(struct interpreter *interpreter, struct node *pipeline, int background);
+
+void sigchld_handler(int signal_number);
+
+void block_sigchld(sigset_t *old_set);
+
+int add_job(pid_t pgid, const pid_t pids[], int process_count, const char command[]);
+
+void remove_job(struct job *job);
+
+void wait_for_job(struct job *job);
+
+void report_finished_jobs();
+
+void jobs_command();
+
+double get_monotonic_time();
+
+double timeval_to_seconds(struct timeval time);
+
+void start_command_usage();
+
+void add_command_usage(const struct rusage *usage);
+
+void finish_command_usage(double start_time);
+
+void times_command();
+
+void wait_command(struct interpreter *interpreter);
+
+unsigned int hash_string(const char input[]);
+
+unsigned int hash_bytes(const char input[], size_t length);
+
+char *find_command_in_path(const char command[]);
+
+char *get_command_path(const char command[]);
+
+void clear_command_hash();
+
+void print_command_hash();
+
+int hash_command(struct interpreter *interpreter);
+
+int main(int argc, char **argv, char **env) {
+    REAL_STDOUT = stdout;
+
+    //run -c, a script or input which is not typed in a terminal without setting up the terminal
+    if (argc > 1 || !isatty(STDIN_FILENO)) {
+        return run_batch(argc, argv);
+    }
+
+    INTERACTIVE = 1;
+
+    //clear any data in the terminal before starting
+    clear_terminal();
+    linenoiseClearScreen();
+
+    //set the history of linenoise
+    linenoiseHistorySetMaxLen(10);
+
+    eggsh_init();
+
+    welcome_message();
+
+    struct interpreter interpreter;
+    start_interpreter_frame(&interpreter, NULL);
+    get_input_from_terminal(&interpreter);
+
+    return EXITCODE;
+}
+
+//function which runs the shell without a terminal, 'eggsh -c command [name [args]]', 'eggsh script [args]'
+//or 'eggsh < script', the lines are read with the script reader instead of linenoise
+//returns the exit code of the last command, which is the exit status of the shell
+int run_batch(int argc, char **argv) {
+    struct script_reader reader;
+    struct interpreter interpreter;
+
+    start_interpreter_frame(&interpreter, NULL);
+
+    if (argc > 1 && strcmp(argv[1], "-c") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "Usage: %s -c command [name [arguments]]\n", argv[0]);
+            return 2;
+        }
+
+        //the words after the command are $0, $1 and so on
+        open_script_text(&reader, argv[2]);
+        interpreter.positional = argc > 3 ? &argv[3] : argv;
+        interpreter.positional_count = argc > 3 ? argc - 3 : 1;
+    } else if (argc > 1) {
+        if (open_script_reader(&reader, argv[1]) != 0) {
+            fprintf(stderr, "%s: %s: %s\n", argv[0], argv[1], strerror(errno));
+            return 127;
+        }
+
+        //the script is $0 and the words after it are $1 and so on
+        interpreter.positional = &argv[1];
+        interpreter.positional_count = argc - 1;
+    } else {
+        open_script_stream(&reader, STDIN_FILENO);
+    }
+
+    eggsh_init();
+
+    //here-documents and lines which continue an 'if', 'while' or 'for' are read from the same input
+    interpreter.reader = &reader;
+    execute_script(&interpreter);
+
+    close_script_reader(&reader);
+
+    return EXITCODE;
+}
+
+//function which initialises shell variables
+void eggsh_init() {
+    //add the shell variables to the variable store, the ones from the environment are also exported
+    //get the search path for external commands
+    add_shell_variable("PATH", &PATH, getenv("PATH") != NULL ? getenv("PATH") : "", VARIABLE_EXPORTED, on_set_path);
+    add_shell_variable("PROMPT", &PROMPT, PROMPT, 0, NULL);
+
+    //the current working directory is only looked up when CWD is read
+    add_computed_variable("CWD", &CWD, on_set_cwd, get_cwd_value);
+
+    //get the USER, HOME and SHELL environmental variables
+    const char *environment_names[] = {"USER", "HOME", "SHELL"};
+    char **environment_globals[] = {&USER, &HOME, &SHELL};
+
+    for (int i = 0; i < 3; i++) {
+        const char *value = getenv(environment_names[i]);
+
+        if (value == NULL && INTERACTIVE) {
+            fprintf(stderr, "Cannot get %s environment variable\n", environment_names[i]);
+        }
+        add_shell_variable(environment_names[i], environment_globals[i], value != NULL ? value : "",
+                           value != NULL ? VARIABLE_EXPORTED : 0, NULL);
+    }
+
+    //the name of the terminal is only looked up when TERMINAL is read
+    add_computed_variable("TERMINAL", &TERMINAL, NULL, get_terminal_value);
+
+    //these variables are kept up to date by the shell
+    add_readonly_variable("EXITCODE", EXITCODE_S);
+    add_readonly_variable("LASTUSER", LASTUSER_S);
+    add_readonly_variable("LASTSYS", LASTSYS_S);
+    add_readonly_variable("LASTWALL", LASTWALL_S);
+    add_readonly_variable("LASTRSS", LASTRSS_S);
+
+    //every other environment variable is kept as an exported variable, so that it is passed on to commands
+    import_environment();
+
+    //choose how external commands are launched, posix_spawn is the default
+    if (getenv("EGGSH_LAUNCHER") != NULL && strcmp(getenv("EGGSH_LAUNCHER"), "fork") == 0) {
+        USE_POSIX_SPAWN = 0;
+    }
+
+    //reap background jobs as soon as they finish
+    struct sigaction child_action;
+    memset(&child_action, 0, sizeof(child_action));
+    child_action.sa_handler = sigchld_handler;
+    child_action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigemptyset(&child_action.sa_mask);
+    if (sigaction(SIGCHLD, &child_action, NULL) != 0) {
+        perror("Cannot set SIGCHLD handler");
+    }
+}
+
+//function that prints the header and a welcome message
+void welcome_message() {
+    print_header();
+    printf("Welcome %s!\n", USER);
+}
+
+//function that prints a line a the title of the shell
+void print_header() {
+    //get the width of the terminal
+    struct winsize terminal_size;
+    ioctl(STDIN_FILENO, TIOCGWINSZ, &terminal_size);
+
+    //print dashed line
+    if (terminal_size.ws_col != 0) {
+        for (int i = 0; i < (terminal_size.ws_col - strlen(TERMINAL_TITLE)) / 2; i++) {
+            printf("-");
+        }
+    }
+
+    //print terminal title
+    printf("%s", TERMINAL_TITLE);
+
+    //print dashed line
+    if (terminal_size.ws_col != 0) {
+        for (int i = 0; i < (terminal_size.ws_col - strlen(TERMINAL_TITLE)) / 2; i++) {
+            printf("-");
+        }
+    }
+
+    printf("\n");
+}
+
+//function which gets the input from the terminal through linenoise
+//checks the input and executes the appropriate set of commands
+void get_input_from_terminal(struct interpreter *interpreter) {
+    char *input = "";
+    int input_length = 0;
+
+    fflush(STDIN_FILENO);
+
+    //get input from terminal
+    while (report_finished_jobs(), (input = linenoise(PROMPT)) != NULL) {
+
+        //store the input in the linenoise history
+        linenoiseHistoryAdd(input);
+
+        input_length = (int) strlen(input);
+
+        //parse and run the whole line, check if 'exit' is entered
+        int exit_terminal = execute_line(interpreter, input);
+
+        //clear the input so that it can be refilled
+        clear_string(input, input_length);
+
+        //free the allocated linenoise input
+        linenoiseFree(input);
+
+        if (exit_terminal == 1) {
+            break;
+        }
+    }
+}
+
+//this function is very similar to previous one but instead of getting
+//input from linoise, the input is received from a file when 'source' is executed
+//the lines are not copied and have no length limit, the file is mapped into memory or read in large blocks
+void get_input_from_file(struct interpreter *interpreter, const char filename[]) {
+    struct script_reader reader;
+
+    //every sourced script uses the C stack, so scripts which never stop sourcing are ended before it runs out
+    if (interpreter->source_depth >= MAX_SOURCE_DEPTH) {
+        printf("%s: maximum source depth exceeded.\n", filename);
+        set_exit_code(EXIT_FAILURE);
+        return;
+    }
+
+    if (open_script_reader(&reader, filename) != 0) {
+        perror("Cannot open file");
+        set_exit_code(EXIT_FAILURE);
+        return;
+    }
+
+    //the script runs in a frame of its own, so a source in a source does not change the arguments of this one
+    //and 'return' in the script only stops the script, not a function which sourced it
+    struct interpreter frame;
+    start_interpreter_frame(&frame, interpreter);
+    frame.source_depth++;
+
+    //here-documents in the file are read from the file as well
+    frame.reader = &reader;
+
+    //'exit' in a sourced script only stops the script
+    execute_script(&frame);
+
+    close_script_reader(&reader);
+}
+
+//function which runs the lines of the script of a frame until its end, 'exit' or 'return'
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int execute_script(struct interpreter *interpreter) {
+    char *line;
+
+    //get inputs from the script line by line, the blocks of earlier lines are no longer used once a line has run
+    while (release_script_blocks(interpreter->reader), (line = next_script_line(interpreter->reader)) != NULL) {
+        //parse and run the whole line, check if 'exit' or 'return' is entered
+        if (execute_line(interpreter, line) == 1) {
+            return 1;
+        }
+        if (interpreter->returning) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+//function which starts a frame of the interpreter, for a source, a function call or a command substitution
+//a new frame has no arguments yet, and keeps the script, depth and function arguments of its parent
+void start_interpreter_frame(struct interpreter *frame, struct interpreter *parent) {
+    memset(frame, 0, sizeof(struct interpreter));
+    frame->parent = parent;
+    frame->args = NO_ARGS;
+
+    if (parent != NULL) {
+        frame->reader = parent->reader;
+        frame->source_depth = parent->source_depth;
+        frame->positional = parent->positional;
+        frame->positional_count = parent->positional_count;
+        frame->call_depth = parent->call_depth;
+    }
+}
+
+//function which opens a script for next_script_line
+//a regular file is mapped privately, so the lines can be terminated in place without changing the file
+//returns 0 if the script was opened, returns 1 otherwise with errno set
+int open_script_reader(struct script_reader *reader, const char filename[]) {
+    struct stat file_status;
+
+    memset(reader, 0, sizeof(struct script_reader));
+
+    reader->fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (reader->fd < 0) {
+        return 1;
+    }
+
+    if (fstat(reader->fd, &file_status) == 0 && S_ISREG(file_status.st_mode) && file_status.st_size > 0) {
+        void *data = mmap(NULL, (size_t) file_status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, reader->fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, (size_t) file_status.st_size, MADV_SEQUENTIAL);
+            reader->data = data;
+            reader->size = (size_t) file_status.st_size;
+            reader->end_of_file = 1;
+            return 0;
+        }
+    }
+
+    //anything which cannot be mapped, such as a pipe, is read in blocks
+    open_script_stream(reader, reader->fd);
+
+    return 0;
+}
+
+//function which sets up next_script_line to read a script from a file descriptor in blocks
+//the input of the shell is read this way rather than mapped, so commands in the script which read it
+//continue after the part the shell has read, as they did with linenoise
+void open_script_stream(struct script_reader *reader, int fd) {
+    memset(reader, 0, sizeof(struct script_reader));
+    reader->fd = fd;
+
+    reader->capacity = SCRIPT_BLOCK_SIZE;
+    reader->data = malloc(reader->capacity);
+    if (reader->data == NULL) {
+        perror("Unable to allocate memory");
+        exit(EXIT_FAILURE);
+    }
+}
+
+//function which sets up next_script_line to read the lines of a string, such as the command given with -c
+//the string is copied, so its lines can be terminated in place
+void open_script_text(struct script_reader *reader, const char text[]) {
+    memset(reader, 0, sizeof(struct script_reader));
+    reader->fd = -1;
+
+    reader->size = strlen(text);
+    reader->capacity = reader->size + 1;
+    reader->data = strdup(text);
+    if (reader->data == NULL) {
+        perror("Unable to allocate memory");
+        exit(EXIT_FAILURE);
+    }
+    reader->end_of_file = 1;
+}
+
+//function which returns the next line of a script without the \n
+//the line points into the script and stays valid until release_script_blocks is called
+//returns the line, or NULL at the end of the script
+char *next_script_line(struct script_reader *reader) {
+    while (1) {
+        char *start = &reader->data[reader->position];
+        size_t available = reader->size - reader->position;
+        char *newline = memchr(start, '\n', available);
+
+        if (newline != NULL) {
+            *newline = '\0';
+            reader->position += (size_t) (newline - start) + 1;
+            reader->lines_given = 1;
+            return start;
+        }
+
+        if (reader->end_of_file) {
+            if (available == 0) {
+                return NULL;
+            }
+            reader->position = reader->size;
+
+            //the last line of a mapped file may end at the end of the mapping, so it is copied to be terminated
+            if (reader->capacity == 0) {
+                return arena_strndup(start, available);
+            }
+            start[available] = '\0';
+            return start;
+        }
+
+        //make room for another block after the part of the line which has been read
+        //a block which lines were handed out from is kept, and the part of the line is moved to a new block
+        if (available + SCRIPT_BLOCK_SIZE + 1 > reader->capacity - reader->position || reader->lines_given) {
+            size_t capacity = available + SCRIPT_BLOCK_SIZE + 1 > reader->capacity ? (available + SCRIPT_BLOCK_SIZE + 1) * 2
+                                                                                     : reader->capacity;
+            char *data;
+
+            if (reader->lines_given) {
+                data = malloc(capacity);
+                if (data != NULL) {
+                    memcpy(data, start, available);
+                    reader->retired = realloc(reader->retired, ((size_t) reader->retired_count + 1) * sizeof(char *));
+                    reader->retired[reader->retired_count++] = reader->data;
+                }
+            } else {
+                memmove(reader->data, start, available);
+                data = realloc(reader->data, capacity);
+            }
+
+            if (data == NULL) {
+                perror("Unable to allocate memory");
+                exit(EXIT_FAILURE);
+            }
+
+            reader->data = data;
+            reader->capacity = capacity;
+            reader->size = available;
+            reader->position = 0;
+            reader->lines_given = 0;
+        }
+
+        ssize_t bytes_read = read(reader->fd, &reader->data[reader->size], reader->capacity - reader->size - 1);
+        if (bytes_read > 0) {
+            reader->size += (size_t) bytes_read;
+        } else if (bytes_read == 0 || errno != EINTR) {
+            if (bytes_read < 0) {
+                perror("Cannot read file");
+            }
+            reader->end_of_file = 1;
+        }
+    }
+}
+
+//function which frees the blocks of a script which only lines that have already run point into
+void release_script_blocks(struct script_reader *reader) {
+    for (int i = 0; i < reader->retired_count; i++) {
+        free(reader->retired[i]);
+    }
+    reader->retired_count = 0;
+}
+
+//function which unmaps or frees a script and closes it
+void close_script_reader(struct script_reader *reader) {
+    release_script_blocks(reader);
+    free(reader->retired);
+
+    if (reader->capacity == 0) {
+        if (reader->data != NULL) {
+            munmap(reader->data, reader->size);
+        }
+    } else {
+        free(reader->data);
+    }
+
+    if (reader->fd >= 0) {
+        close(reader->fd);
+    }
+}
+
+//function which tokenises a line, parses it into a syntax tree and runs it
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int execute_line(struct interpreter *interpreter, char line[]) {
+    int exit_terminal = 0;
+    int position = 0;
+    struct token_list list = {NULL, 0, 0};
+
+    //everything allocated for this line is released at the end, lines run by 'source' take their own mark
+    struct arena_mark mark = arena_get_mark();
+
+    //split the line into tokens in one pass, the tree points to the tokens so they are not scanned again
+    //the bodies of any here-documents are the lines after this one, so they are read before anything is run
+    if (tokenise_input(line, &list) != 0 || read_here_documents(interpreter, &list, 0) != 0) {
+        set_exit_code(EXIT_FAILURE);
+    } else if (list.count > 0) {
+        struct node *tree = parse_list(list.tokens, list.count, &position);
+
+        //an 'if', 'while' or 'for' which is not finished goes on to the next lines, and is parsed again once it is whole
+        while (tree == NULL && PARSE_INCOMPLETE && read_continuation_line(interpreter, &list) == 0) {
+            position = 0;
+            tree = parse_list(list.tokens, list.count, &position);
+        }
+
+        if (tree == NULL && PARSE_INCOMPLETE) {
+            PARSE_INCOMPLETE = 0;
+            print_syntax_error(list.tokens, list.count, list.count);
+        } else if (tree != NULL && position < list.count) {
+            print_syntax_error(list.tokens, list.count, position);
+        } else if (tree != NULL) {
+            exit_terminal = evaluate_node(interpreter, tree);
+        }
+    }
+
+    //null all the input arguments, they point into memory which is released with the line
+    clear_and_null_args(interpreter);
+    GLOB_CACHE = NULL;
+    arena_release(mark);
+
+    return exit_terminal;
+}
+
+//function which reads the next line of a command which is not finished, and adds its tokens after a newline
+//returns 0 if a line was added, returns 1 at the end of the input or if the line is not valid
+int read_continuation_line(struct interpreter *interpreter, struct token_list *list) {
+    struct token_list line_tokens = {NULL, 0, 0};
+    char *line;
+
+    PARSE_INCOMPLETE = 0;
+
+    if ((line = read_here_document_line(interpreter)) == NULL) {
+        PARSE_INCOMPLETE = 1;
+        return 1;
+    }
+
+    if (tokenise_input(line, &line_tokens) != 0) {
+        set_exit_code(EXIT_FAILURE);
+        return 1;
+    }
+
+    int start = list->count;
+    add_token(list, TOKEN_NEWLINE, "newline", (int) strlen("newline"), 0);
+    for (int i = 0; i < line_tokens.count; i++) {
+        add_token(list, line_tokens.tokens[i].type, line_tokens.tokens[i].text, line_tokens.tokens[i].length,
+                  line_tokens.tokens[i].flags);
+    }
+
+    //only the here-documents of the new line are read, the earlier ones already have their bodies
+    return read_here_documents(interpreter, list, start);
+}
+
+//function which reads the body of every '<<' here-document in the line, in the order they appear
+//the word after '<<' is the delimiter, and it is replaced by the lines read up to the delimiter
+//the body is expanded like text in double quotes unless the delimiter is quoted
+//returns 0 if every body was read, returns 1 if a delimiter is missing
+int read_here_documents(struct interpreter *interpreter, struct token_list *list, int start) {
+    for (int i = start; i < list->count; i++) {
+        if (list->tokens[i].type != TOKEN_HERE_DOCUMENT) {
+            continue;
+        }
+
+        if (i + 1 == list->count || list->tokens[i + 1].type != TOKEN_WORD) {
+            print_syntax_error(list->tokens, list->count, i + 1);
+            return 1;
+        }
+
+        struct token *delimiter_token = &list->tokens[i + 1];
+        char *delimiter = expand_word(interpreter, delimiter_token);
+        size_t capacity = MAX_LENGTH;
+        size_t length = 0;
+        char *body = arena_alloc(capacity);
+        char *line;
+
+        while ((line = read_here_document_line(interpreter)) != NULL && strcmp(line, delimiter) != 0) {
+            size_t line_length = strlen(line);
+
+            if (length + line_length + 2 > capacity) {
+                size_t new_capacity = capacity * 2 > length + line_length + 2 ? capacity * 2 : length + line_length + 2;
+                body = arena_grow(body, capacity, new_capacity);
+                capacity = new_capacity;
+            }
+
+            memcpy(&body[length], line, line_length);
+            body[length + line_length] = '\n';
+            length += line_length + 1;
+        }
+        body[length] = '\0';
+
+        delimiter_token->flags = delimiter_token->flags & WORD_QUOTED ? 0 : WORD_HERE_DOCUMENT;
+        delimiter_token->text = body;
+        delimiter_token->length = (int) length;
+    }
+
+    return 0;
+}
+
+//function which reads the next line of a here-document, from the sourced script or from the terminal
+//returns the line without the \n, which is valid until the line it belongs to has run, or NULL at the end of the input
+char *read_here_document_line(struct interpreter *interpreter) {
+    if (interpreter->reader != NULL) {
+        return next_script_line(interpreter->reader);
+    }
+
+    char *line = linenoise("> ");
+    if (line == NULL) {
+        return NULL;
+    }
+
+    char *copy = arena_strndup(line, strlen(line));
+    linenoiseFree(line);
+
+    return copy;
+}
+
+//function which prints an error for the token at the given position and sets EXITCODE
+//if the tokens end inside an 'if', 'while' or 'for', nothing is printed and PARSE_INCOMPLETE is set instead
+void print_syntax_error(struct token tokens[], int token_count, int position) {
+    if (position >= token_count && PARSE_DEPTH > 0) {
+        PARSE_INCOMPLETE = 1;
+        return;
+    }
+
+    if (position < token_count) {
+        printf("Syntax error near '%s'.\n", tokens[position].text);
+    } else {
+        printf("Syntax error near end of line.\n");
+    }
+
+    set_exit_code(EXIT_FAILURE);
+}
+
+//function which parses a list of commands separated by ';', '&' or newlines, starting at the given position
+//the list ends at the end of the tokens, or at a keyword such as 'then' or 'done' which ends the body of an if or loop
+//the position is moved past the tokens that were used
+//returns the syntax tree, or NULL if there is a syntax error
+struct node *parse_list(struct token tokens[], int token_count, int *position) {
+    //the body of an if or loop may start on the next line
+    while (*position < token_count && tokens[*position].type == TOKEN_NEWLINE) {
+        (*position)++;
+    }
+
+    struct node *tree = parse_and_or(tokens, token_count, position);
+
+    while (tree != NULL && *position < token_count && is_separator(tokens[*position].type)) {
+        //'&' puts the pipeline before it in the background
+        if (tokens[*position].type == TOKEN_BACKGROUND) {
+            struct node *last = tree;
+            while (last->type == NODE_SEQUENCE || last->type == NODE_AND || last->type == NODE_OR) {
+                last = last->right;
+            }
+
+            //an if or loop is run by the shell itself, so it cannot be put in the background
+            if (last->type != NODE_COMMAND && last->type != NODE_PIPE) {
+                print_syntax_error(tokens, token_count, *position);
+                return NULL;
+            }
+            last->background = 1;
+        }
+
+        (*position)++;
+        while (*position < token_count && tokens[*position].type == TOKEN_NEWLINE) {
+            (*position)++;
+        }
+
+        //a ';' or '&' is allowed at the end of the line and at the end of a body
+        if (*position == token_count || is_list_terminator(&tokens[*position])) {
+            break;
+        }
+
+        struct node *right = parse_and_or(tokens, token_count, position);
+        if (right == NULL) {
+            return NULL;
+        }
+
+        tree = new_node(NODE_SEQUENCE, tree, right);
+    }
+
+    return tree;
+}
+
+//function which checks if a token ends a command in a list
+//returns 1 if it is ';', '&' or a newline, returns 0 otherwise
+int is_separator(enum token_type type) {
+    return type == TOKEN_SEMICOLON || type == TOKEN_BACKGROUND || type == TOKEN_NEWLINE;
+}
+
+//function which parses pipelines joined by '&&' and '||', starting at the given position
+//returns the syntax tree, or NULL if there is a syntax error
+struct node *parse_and_or(struct token tokens[], int token_count, int *position) {
+    struct node *tree = parse_pipeline(tokens, token_count, position);
+
+    while (tree != NULL && *position < token_count &&
+           (tokens[*position].type == TOKEN_AND || tokens[*position].type == TOKEN_OR)) {
+        enum node_type type = tokens[*position].type == TOKEN_AND ? NODE_AND : NODE_OR;
+        (*position)++;
+
+        struct node *right = parse_pipeline(tokens, token_count, position);
+        if (right == NULL) {
+            return NULL;
+        }
+
+        tree = new_node(type, tree, right);
+    }
+
+    return tree;
+}
+
+//function which parses commands joined by '|', which may be prefixed by 'time'
+//returns the syntax tree, or NULL if there is a syntax error
+struct node *parse_pipeline(struct token tokens[], int token_count, int *position) {
+    int timed = 0;
+
+    //'time' is only a keyword when it is not quoted and a command follows it
+    if (*position + 1 < token_count && tokens[*position].type == TOKEN_WORD && tokens[*position].flags == 0 &&
+        strcmp(tokens[*position].text, "time") == 0 && tokens[*position + 1].type == TOKEN_WORD) {
+        timed = 1;
+        (*position)++;
+    }
+
+    struct node *tree = parse_command(tokens, token_count, position);
+
+    while (tree != NULL && *position < token_count && tokens[*position].type == TOKEN_PIPE) {
+        //the stages of a pipeline are run as child processes, so an if or loop cannot be one of them
+        if (tree->type != NODE_COMMAND && tree->type != NODE_PIPE) {
+            print_syntax_error(tokens, token_count, *position);
+            return NULL;
+        }
+
+        (*position)++;
+
+        int stage = *position;
+        struct node *right = parse_command(tokens, token_count, position);
+        if (right == NULL) {
+            return NULL;
+        }
+
+        if (right->type != NODE_COMMAND) {
+            print_syntax_error(tokens, token_count, stage);
+            return NULL;
+        }
+
+        tree = new_node(NODE_PIPE, tree, right);
+    }
+
+    if (tree != NULL) {
+        tree->timed = timed;
+    }
+
+    return tree;
+}
+
+//function which parses a single command, which is every token up to the next '|' or list operator
+//the words and the redirections are split here, so that redirections can be written anywhere in the command
+//a command starting with 'if', 'while' or 'for' is parsed as a whole if or loop instead
+//returns the command node, or NULL if there is a syntax error
+struct node *parse_command(struct token tokens[], int token_count, int *position) {
+    int start = *position;
+
+    if (*position < token_count && is_compound_keyword(&tokens[*position])) {
+        return parse_compound_command(tokens, token_count, position);
+    }
+
+    //'NAME()' or 'NAME ()' followed by a body in braces defines a function, and so does 'NAME(){' written together
+    if (*position < token_count && tokens[*position].type == TOKEN_WORD && tokens[*position].flags == 0 &&
+        ((tokens[*position].length > 2 && strcmp(&tokens[*position].text[tokens[*position].length - 2], "()") == 0) ||
+         (*position + 1 < token_count && is_keyword(&tokens[*position + 1], "()")))) {
+        return parse_function_definition(tokens, token_count, position);
+    }
+    if (*position < token_count && is_function_start(&tokens[*position])) {
+        return parse_function_definition(tokens, token_count, position);
+    }
+
+    //the keywords which end a body cannot be used as a command
+    if (*position < token_count && is_list_terminator(&tokens[*position])) {
+        print_syntax_error(tokens, token_count, *position);
+        return NULL;
+    }
+
+    struct node *command = new_node(NODE_COMMAND, NULL, NULL);
+    struct redirection **last_redirection = &command->redirections;
+
+    while (*position < token_count && tokens[*position].type != TOKEN_PIPE &&
+           !is_separator(tokens[*position].type) &&
+           tokens[*position].type != TOKEN_AND && tokens[*position].type != TOKEN_OR) {
+        if (tokens[*position].type == TOKEN_WORD) {
+            (*position)++;
+            continue;
+        }
+
+        if ((last_redirection = parse_redirection(tokens, token_count, position, last_redirection)) == NULL) {
+            return NULL;
+        }
+    }
+
+    command->tokens = &tokens[start];
+    command->token_count = *position - start;
+
+    //copy the words which are not part of a redirection
+    command->words = arena_alloc(command->token_count * sizeof(struct token) + 1);
+    for (int i = start; i < *position; i++) {
+        if (tokens[i].type == TOKEN_WORD && (i == start || !is_redirection(tokens[i - 1].type))) {
+            command->words[command->word_count++] = tokens[i];
+        }
+    }
+
+    //a command has to have at least one word
+    if (command->word_count == 0) {
+        print_syntax_error(tokens, token_count, *position);
+        return NULL;
+    }
+
+    return command;
+}
+
+//function which parses a redirection, which is an optional file descriptor, the operator and the word after it
+//the redirection is added to the end of the list of redirections
+//returns where the next redirection is added, or NULL if there is a syntax error
+struct redirection **parse_redirection(struct token tokens[], int token_count, int *position,
+                                       struct redirection **last_redirection) {
+    struct redirection *redirection = arena_alloc(sizeof(struct redirection));
+    redirection->fd = -1;
+    if (tokens[*position].type == TOKEN_IO_NUMBER) {
+        redirection->fd = atoi(tokens[*position].text);
+        (*position)++;
+    }
+
+    if (*position + 1 >= token_count || !is_redirection(tokens[*position].type) ||
+        tokens[*position + 1].type != TOKEN_WORD) {
+        print_syntax_error(tokens, token_count, *position + 1 < token_count ? *position + 1 : token_count);
+        return NULL;
+    }
+
+    redirection->type = tokens[*position].type;
+    redirection->target = &tokens[*position + 1];
+    redirection->next = NULL;
+    *last_redirection = redirection;
+
+    *position += 2;
+
+    return &redirection->next;
+}
+
+//function which parses an 'if', 'while' or 'for', starting at its keyword
+//the body is parsed into a tree once here, and the tree is run again for every iteration of a loop
+//returns the node, or NULL if there is a syntax error
+struct node *parse_compound_command(struct token tokens[], int token_count, int *position) {
+    struct node *node;
+
+    //a syntax error at the end of the tokens means that the rest is on the next line
+    PARSE_DEPTH++;
+    if (is_keyword(&tokens[*position], "if")) {
+        node = parse_if(tokens, token_count, position);
+    } else if (is_keyword(&tokens[*position], "while")) {
+        node = parse_while(tokens, token_count, position);
+    } else {
+        node = parse_for(tokens, token_count, position);
+    }
+    PARSE_DEPTH--;
+
+    //redirections after the 'fi' or 'done' apply to everything inside
+    struct redirection **last_redirection = node != NULL ? &node->redirections : NULL;
+    while (last_redirection != NULL && *position < token_count &&
+           (tokens[*position].type == TOKEN_IO_NUMBER || is_redirection(tokens[*position].type))) {
+        last_redirection = parse_redirection(tokens, token_count, position, last_redirection);
+    }
+
+    return last_redirection != NULL ? node : NULL;
+}
+
+//function which parses 'if list; then list; [elif list; then list;]... [else list;] fi'
+//an 'elif' is parsed as another if node after the else, which ends at the same 'fi'
+//returns the node, or NULL if there is a syntax error
+struct node *parse_if(struct token tokens[], int token_count, int *position) {
+    //skip the 'if' or 'elif'
+    (*position)++;
+
+    struct node *condition = parse_list(tokens, token_count, position);
+    if (condition == NULL || !expect_keyword(tokens, token_count, position, "then")) {
+        return NULL;
+    }
+
+    struct node *body = parse_list(tokens, token_count, position);
+    if (body == NULL) {
+        return NULL;
+    }
+
+    struct node *node = new_node(NODE_IF, condition, body);
+
+    if (*position < token_count && is_keyword(&tokens[*position], "elif")) {
+        node->else_branch = parse_if(tokens, token_count, position);
+        return node->else_branch != NULL ? node : NULL;
+    }
+
+    if (*position < token_count && is_keyword(&tokens[*position], "else")) {
+        (*position)++;
+        if ((node->else_branch = parse_list(tokens, token_count, position)) == NULL) {
+            return NULL;
+        }
+    }
+
+    return expect_keyword(tokens, token_count, position, "fi") ? node : NULL;
+}
+
+//function which parses 'while list; do list; done'
+//returns the node, or NULL if there is a syntax error
+struct node *parse_while(struct token tokens[], int token_count, int *position) {
+    (*position)++;
+
+    struct node *condition = parse_list(tokens, token_count, position);
+    if (condition == NULL || !expect_keyword(tokens, token_count, position, "do")) {
+        return NULL;
+    }
+
+    struct node *body = parse_list(tokens, token_count, position);
+    if (body == NULL || !expect_keyword(tokens, token_count, position, "done")) {
+        return NULL;
+    }
+
+    return new_node(NODE_WHILE, condition, body);
+}
+
+//function which parses 'for NAME in words; do list; done'
+//the words are kept as tokens, they are expanded one at a time while the loop runs
+//returns the node, or NULL if there is a syntax error
+struct node *parse_for(struct token tokens[], int token_count, int *position) {
+    (*position)++;
+
+    if (*position >= token_count || tokens[*position].type != TOKEN_WORD || tokens[*position].flags != 0 ||
+        check_var_name_validity(tokens[*position].text, tokens[*position].length) == 0) {
+        print_syntax_error(tokens, token_count, *position);
+        return NULL;
+    }
+
+    struct node *node = new_node(NODE_FOR, NULL, NULL);
+    node->name = tokens[*position].text;
+    (*position)++;
+
+    if (!expect_keyword(tokens, token_count, position, "in")) {
+        return NULL;
+    }
+
+    //the words go up to the ';' or newline before the 'do'
+    node->words = &tokens[*position];
+    while (*position < token_count && tokens[*position].type == TOKEN_WORD) {
+        (*position)++;
+        node->word_count++;
+    }
+
+    if (*position >= token_count ||
+        (tokens[*position].type != TOKEN_SEMICOLON && tokens[*position].type != TOKEN_NEWLINE)) {
+        print_syntax_error(tokens, token_count, *position);
+        return NULL;
+    }
+
+    do {
+        (*position)++;
+    } while (*position < token_count && tokens[*position].type == TOKEN_NEWLINE);
+
+    if (!expect_keyword(tokens, token_count, position, "do")) {
+        return NULL;
+    }
+
+    if ((node->right = parse_list(tokens, token_count, position)) == NULL ||
+        !expect_keyword(tokens, token_count, position, "done")) {
+        return NULL;
+    }
+
+    return node;
+}
+
+//function which parses 'NAME() { list; }', the body may start on the next line
+//the tokens of the body are kept in the node, so that the function can copy them when it is defined
+//returns the node, or NULL if there is a syntax error
+struct node *parse_function_definition(struct token tokens[], int token_count, int *position) {
+    struct token *name = &tokens[*position];
+    int name_length = name->length;
+    int brace_in_name = is_function_start(name);
+
+    if (brace_in_name) {
+        name_length -= 3;
+        (*position)++;
+    } else if (*position + 1 < token_count && is_keyword(&tokens[*position + 1], "()")) {
+        *position += 2;
+    } else {
+        name_length -= 2;
+        (*position)++;
+    }
+
+    if (check_var_name_validity(name->text, name_length) == 0) {
+        print_syntax_error(tokens, token_count, *position - 1);
+        return NULL;
+    }
+
+    PARSE_DEPTH++;
+    while (!brace_in_name && *position < token_count && tokens[*position].type == TOKEN_NEWLINE) {
+        (*position)++;
+    }
+
+    int body_start = brace_in_name ? *position : *position + 1;
+    struct node *body = NULL;
+    if ((brace_in_name || expect_keyword(tokens, token_count, position, "{")) &&
+        (body = parse_list(tokens, token_count, position)) != NULL &&
+        !expect_keyword(tokens, token_count, position, "}")) {
+        body = NULL;
+    }
+    PARSE_DEPTH--;
+
+    if (body == NULL) {
+        return NULL;
+    }
+
+    struct node *node = new_node(NODE_FUNCTION, NULL, body);
+    node->name = arena_strndup(name->text, (size_t) name_length);
+    node->tokens = &tokens[body_start];
+    node->token_count = *position - 1 - body_start;
+
+    return node;
+}
+
+//function which checks if a word is 'NAME(){', a function name and the brace of its body written together
+//returns 1 if it is, returns 0 otherwise
+int is_function_start(const struct token *token) {
+    return token->type == TOKEN_WORD && token->flags == WORD_BRACE && token->length > 3 &&
+           strcmp(&token->text[token->length - 3], "(){") == 0;
+}
+
+//function which moves past a keyword which has to come next, such as the 'then' of an if
+//returns 1 if the keyword is there, otherwise prints a syntax error and returns 0
+int expect_keyword(struct token tokens[], int token_count, int *position, const char keyword[]) {
+    if (*position < token_count && is_keyword(&tokens[*position], keyword)) {
+        (*position)++;
+        return 1;
+    }
+
+    print_syntax_error(tokens, token_count, *position);
+    return 0;
+}
+
+//function which checks if a token is the given keyword, keywords are only recognised when they are not quoted
+//returns 1 if it is, returns 0 otherwise
+int is_keyword(const struct token *token, const char keyword[]) {
+    //'{' is marked as a possible brace expansion by the lexer
+    return token->type == TOKEN_WORD && (token->flags & ~WORD_BRACE) == 0 && strcmp(token->text, keyword) == 0;
+}
+
+//function which checks if a token starts an if or a loop
+//returns 1 if it does, returns 0 otherwise
+int is_compound_keyword(const struct token *token) {
+    return is_keyword(token, "if") || is_keyword(token, "while") || is_keyword(token, "for");
+}
+
+//function which checks if a token is a keyword which ends the condition or body of an if, a loop or a function
+//returns 1 if it is, returns 0 otherwise
+int is_list_terminator(const struct token *token) {
+    static const char *keywords[] = {"then", "elif", "else", "fi", "do", "done", "}"};
+
+    for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+        if (is_keyword(token, keywords[i])) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+//function which checks if a token is a redirection operator
+//returns 1 if it is, returns 0 otherwise
+int is_redirection(enum token_type type) {
+    switch (type) {
+        case TOKEN_REDIRECT_OUT:
+        case TOKEN_REDIRECT_APPEND:
+        case TOKEN_REDIRECT_IN:
+        case TOKEN_HERE_STRING:
+        case TOKEN_HERE_DOCUMENT:
+        case TOKEN_DUP_OUT:
+        case TOKEN_DUP_IN:
+        case TOKEN_READ_WRITE:
+        case TOKEN_OUT_ALL:
+        case TOKEN_APPEND_ALL:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+//function which allocates a node of the syntax tree from the line arena
+struct node *new_node(enum node_type type, struct node *left, struct node *right) {
+    struct node *node = arena_alloc(sizeof(struct node));
+
+    memset(node, 0, sizeof(struct node));
+
+    node->type = type;
+    node->left = left;
+    node->right = right;
+
+    return node;
+}
+
+//function which runs a syntax tree
+//the right side of '&&' only runs if EXITCODE is 0, and the right side of '||' only runs if it is not
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int evaluate_node(struct interpreter *interpreter, struct node *node) {
+    switch (node->type) {
+        case NODE_COMMAND:
+        case NODE_PIPE:
+            //measure the command if it was prefixed by 'time'
+            return node->timed ? execute_timed_command(interpreter, node) : execute_pipeline_node(interpreter, node);
+        case NODE_SEQUENCE:
+            //nothing more is run once 'return' is entered
+            if (evaluate_node(interpreter, node->left) == 1) {
+                return 1;
+            }
+            return interpreter->returning ? 0 : evaluate_node(interpreter, node->right);
+        case NODE_AND:
+            if (evaluate_node(interpreter, node->left) == 1) {
+                return 1;
+            }
+            return EXITCODE == 0 && !interpreter->returning ? evaluate_node(interpreter, node->right) : 0;
+        case NODE_OR:
+            if (evaluate_node(interpreter, node->left) == 1) {
+                return 1;
+            }
+            return EXITCODE != 0 && !interpreter->returning ? evaluate_node(interpreter, node->right) : 0;
+        case NODE_IF:
+        case NODE_WHILE:
+        case NODE_FOR:
+            return node->timed ? execute_timed_command(interpreter, node) : evaluate_compound_node(interpreter, node);
+        case NODE_FUNCTION:
+            define_function(node);
+            set_exit_code(0);
+            return 0;
+    }
+
+    return 0;
+}
+
+//function which runs an if, while or for node of the syntax tree
+//redirections after the 'fi' or 'done' are made in the shell once, around the whole if or loop
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int evaluate_compound_node(struct interpreter *interpreter, struct node *node) {
+    struct redirection_plan plan;
+    struct fd_action *saved_fds = NULL;
+    int exit_terminal;
+
+    if (node->type != NODE_IF && node->type != NODE_WHILE && node->type != NODE_FOR) {
+        return execute_pipeline_node(interpreter, node);
+    }
+
+    if (node->redirections != NULL) {
+        if (prepare_redirections(interpreter, node->redirections, &plan) != 0) {
+            set_exit_code(EXIT_FAILURE);
+            return 0;
+        }
+
+        if (plan.action_count > 0 && (saved_fds = apply_redirections_in_shell(&plan)) == NULL) {
+            close_redirection_files(&plan);
+            set_exit_code(EXIT_FAILURE);
+            return 0;
+        }
+    }
+
+    if (node->type == NODE_IF) {
+        exit_terminal = execute_if_node(interpreter, node);
+    } else if (node->type == NODE_WHILE) {
+        exit_terminal = execute_while_node(interpreter, node);
+    } else {
+        exit_terminal = execute_for_node(interpreter, node);
+    }
+
+    if (node->redirections != NULL) {
+        if (saved_fds != NULL) {
+            restore_redirections_in_shell(saved_fds, plan.action_count);
+        }
+        close_redirection_files(&plan);
+    }
+
+    return exit_terminal;
+}
+
+//function which runs the body of an if if its condition sets EXITCODE to 0, or else the else branch
+//EXITCODE is set to 0 if no branch is run
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int execute_if_node(struct interpreter *interpreter, struct node *node) {
+    if (evaluate_node(interpreter, node->left) == 1) {
+        return 1;
+    }
+
+    if (interpreter->returning) {
+        return 0;
+    }
+
+    if (EXITCODE == 0) {
+        return evaluate_node(interpreter, node->right);
+    }
+
+    if (node->else_branch != NULL) {
+        return evaluate_node(interpreter, node->else_branch);
+    }
+
+    set_exit_code(0);
+    return 0;
+}
+
+//function which runs the body of a while loop for as long as its condition sets EXITCODE to 0
+//the tree is run again for every iteration without parsing anything, and what an iteration allocates is released after it
+//EXITCODE is left as the last body set it, or 0 if the body never ran
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int execute_while_node(struct interpreter *interpreter, struct node *node) {
+    int exit_terminal = 0;
+    int exit_code = 0;
+
+    while (1) {
+        struct arena_mark mark = arena_get_mark();
+
+        exit_terminal = evaluate_node(interpreter, node->left);
+        int run_body = exit_terminal == 0 && EXITCODE == 0 && !interpreter->returning;
+        if (run_body) {
+            exit_terminal = evaluate_node(interpreter, node->right);
+            exit_code = EXITCODE;
+        }
+
+        //the arguments and any directories read for globs are in the memory which is released
+        clear_and_null_args(interpreter);
+        GLOB_CACHE = NULL;
+        arena_release(mark);
+
+        if (!run_body || exit_terminal == 1 || interpreter->returning) {
+            break;
+        }
+    }
+
+    //'return' leaves EXITCODE as it set it
+    if (exit_terminal == 0 && !interpreter->returning) {
+        set_exit_code(exit_code);
+    }
+
+    return exit_terminal;
+}
+
+//function which runs the body of a for loop once for each word after 'in'
+//the words are expanded one at a time, so a range such as {1..1000000} is never stored as a whole
+//the value of the variable is copied into it in place, and what an iteration allocates is released after it
+//EXITCODE is left as the last body set it, or 0 if the body never ran
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int execute_for_node(struct interpreter *interpreter, struct node *node) {
+    struct word_source source;
+    int exit_code = 0;
+    char *word;
+
+    start_word_source(interpreter, &source, node->words, node->word_count);
+    interpreter->expansion_failed = 0;
+
+    while ((word = next_word(&source)) != NULL) {
+        //a word whose $((...)) could not be evaluated stops the loop
+        if (interpreter->expansion_failed) {
+            interpreter->expansion_failed = 0;
+            set_exit_code(EXIT_FAILURE);
+            return 0;
+        }
+
+        //the variable is looked up again for every word, since the body may unset it
+        struct variable *variable = find_variable(node->name, strlen(node->name));
+        if (variable == NULL) {
+            variable = add_variable(node->name, strlen(node->name), 0);
+        }
+
+        if (set_variable_value(variable, word) != 0) {
+            set_exit_code(EXIT_FAILURE);
+            return 0;
+        }
+
+        struct arena_mark mark = arena_get_mark();
+        int exit_terminal = evaluate_node(interpreter, node->right);
+        exit_code = EXITCODE;
+
+        clear_and_null_args(interpreter);
+        GLOB_CACHE = NULL;
+        arena_release(mark);
+
+        if (exit_terminal == 1) {
+            return 1;
+        }
+        if (interpreter->returning) {
+            return 0;
+        }
+    }
+
+    set_exit_code(exit_code);
+    return 0;
+}
+
+//function which defines the function of a NODE_FUNCTION node, replacing any function with the same name
+//the line the tokens are in is released once it has run, so the tokens of the body are copied into the arena
+//of the function and parsed into the tree which every call runs
+void define_function(struct node *node) {
+    unsigned int hash = hash_string(node->name);
+
+    for (struct function **link = &FUNCTIONS; *link != NULL; link = &(*link)->next) {
+        if ((*link)->hash == hash && strcmp((*link)->name, node->name) == 0) {
+            struct function *old_function = *link;
+            *link = old_function->next;
+
+            //a function which defines itself again is running, so it is freed once its calls have finished
+            if (old_function->calls > 0) {
+                old_function->replaced = 1;
+            } else {
+                free_function(old_function);
+            }
+            break;
+        }
+    }
+
+    struct function *function = calloc(1, sizeof(struct function) + strlen(node->name) + 1);
+    if (function == NULL) {
+        perror("Unable to allocate memory");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(function->name, node->name);
+    function->hash = hash;
+
+    //the parser allocates from the line arena, so the arena of the function takes its place while the body is parsed
+    struct arena line_arena = LINE_ARENA;
+    LINE_ARENA = (struct arena) {NULL, NULL, NULL, FUNCTION_BLOCK_SIZE};
+
+    struct token *tokens = arena_alloc(node->token_count * sizeof(struct token));
+    for (int i = 0; i < node->token_count; i++) {
+        tokens[i] = node->tokens[i];
+        tokens[i].text = arena_strndup(node->tokens[i].text, (size_t) node->tokens[i].length);
+    }
+
+    int position = 0;
+    function->body = parse_list(tokens, node->token_count, &position);
+
+    function->arena = LINE_ARENA;
+    LINE_ARENA = line_arena;
+
+    function->next = FUNCTIONS;
+    FUNCTIONS = function;
+}
+
+//function which finds a function by its name
+//returns the function, or NULL if there is no function with that name
+struct function *find_function(const char name[]) {
+    if (FUNCTIONS == NULL) {
+        return NULL;
+    }
+
+    unsigned int hash = hash_string(name);
+
+    for (struct function *function = FUNCTIONS; function != NULL; function = function->next) {
+        if (function->hash == hash && strcmp(function->name, name) == 0) {
+            return function;
+        }
+    }
+
+    return NULL;
+}
+
+//function which frees a function and the tree of its body
+void free_function(struct function *function) {
+    free_arena(&function->arena);
+    free(function);
+}
+
+//function which calls a function in the shell without forking, the words of the command become $0 to $N of the call
+//the body runs in a frame of its own, so 'return' only stops this call
+//the redirections of the call are made around the whole body
+//EXITCODE is left as the last command of the body or 'return' set it
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int call_function(struct interpreter *interpreter, struct function *function, const struct redirection_plan *plan) {
+    struct interpreter frame;
+    struct fd_action *saved_fds = NULL;
+
+    start_interpreter_frame(&frame, interpreter);
+    frame.positional = interpreter->args;
+    frame.positional_count = interpreter->arg_count;
+    frame.call_depth++;
+
+    //every call uses the C stack, so calls which never stop are ended before it runs out
+    if (frame.call_depth > MAX_CALL_DEPTH) {
+        printf("%s: maximum function call depth exceeded.\n", function->name);
+        set_exit_code(EXIT_FAILURE);
+        return 0;
+    }
+
+    if (plan != NULL && plan->action_count > 0 && (saved_fds = apply_redirections_in_shell(plan)) == NULL) {
+        set_exit_code(EXIT_FAILURE);
+        return 0;
+    }
+
+    function->calls++;
+
+    int exit_terminal = evaluate_node(&frame, function->body);
+
+    function->calls--;
+
+    if (function->calls == 0 && function->replaced) {
+        free_function(function);
+    }
+
+    if (saved_fds != NULL) {
+        restore_redirections_in_shell(saved_fds, plan->action_count);
+    }
+
+    return exit_terminal;
+}
+
+//function which stops the function or sourced script which is running, 'return [n]'
+//returns n as the exit code, or EXITCODE if n is not given
+int return_command(struct interpreter *interpreter) {
+    int exit_code = EXITCODE;
+
+    if (interpreter->call_depth == 0 && interpreter->source_depth == 0) {
+        printf("return: can only be used in a function or a sourced script.\n");
+        return EXIT_FAILURE;
+    }
+
+    if (interpreter->arg_count > 1) {
+        char *end;
+        errno = 0;
+        long value = strtol(interpreter->args[1], &end, 10);
+
+        if (errno != 0 || end == interpreter->args[1] || *end != '\0') {
+            printf("return: %s: numeric argument required\n", interpreter->args[1]);
+            exit_code = EXIT_FAILURE;
+        } else {
+            exit_code = (int) (value & 255);
+        }
+    }
+
+    interpreter->returning = 1;
+    return exit_code;
+}
+
+//function which gets the exit status of the shell for 'exit [n]'
+//returns n, or EXITCODE if n is not given, so that 'false; exit' exits with the status of 'false'
+int exit_command(struct interpreter *interpreter) {
+    if (interpreter->arg_count == 1) {
+        return EXITCODE;
+    }
+
+    char *end;
+    errno = 0;
+    long value = strtol(interpreter->args[1], &end, 10);
+
+    if (errno != 0 || end == interpreter->args[1] || *end != '\0') {
+        printf("exit: %s: numeric argument required\n", interpreter->args[1]);
+        return EXIT_FAILURE;
+    }
+
+    return (int) (value & 255);
+}
+
+//function which checks if the text after a $ is a positional parameter, such as 1, {10} or #
+//returns 1 if it is, returns 0 otherwise
+int is_positional_parameter(const char text[]) {
+    if (text[0] != '{') {
+        return isdigit((unsigned char) text[0]) || text[0] == '#';
+    }
+
+    int i = 1;
+    while (isdigit((unsigned char) text[i])) {
+        i++;
+    }
+
+    return i > 1 && text[i] == '}';
+}
+
+//function which gets a positional parameter of the function being called, from the text after the $
+//$0 is the name of the function, $# is the number of arguments and an argument which was not given is empty
+//returns the value, and sets name_length to the number of characters after the $ which were used
+const char *get_positional_parameter(struct interpreter *interpreter, const char text[], int *name_length) {
+    if (text[0] == '#') {
+        char *count = arena_alloc(16);
+        sprintf(count, "%d", interpreter->positional_count - 1);
+        *name_length = 1;
+        return count;
+    }
+
+    //without braces only one digit is used, so $10 is $1 followed by 0
+    int braces = text[0] == '{';
+    int index = 0;
+    int length = braces;
+    do {
+        if (index < INT_MAX / 10) {
+            index = index * 10 + (text[length] - '0');
+        }
+        length++;
+    } while (braces && isdigit((unsigned char) text[length]));
+
+    *name_length = length + braces;
+
+    return index < interpreter->positional_count ? interpreter->positional[index] : "";
+}
+
+//function which runs a command or a pipeline node of the syntax tree
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int execute_pipeline_node(struct interpreter *interpreter, struct node *node) {
+    //pipelines and background commands are started as child processes
+    if (node->type == NODE_PIPE || node->background) {
+        execute_pipeline(interpreter, node, node->background);
+        return 0;
+    }
+
+    return execute_simple_command(interpreter, node);
+}
+
+//function which runs one command node of the syntax tree
+//the words of the node are expanded into the arguments of the interpreter, then VAR=VALUE and redirection are checked
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int execute_simple_command(struct interpreter *interpreter, struct node *node) {
+    //directories read for an earlier command may have been changed by it
+    GLOB_CACHE = NULL;
+
+    //'print' in the shell prints its words as they are expanded, so a large brace expansion is never stored
+    struct word_source print_words;
+    if (is_lazy_print(node)) {
+        start_word_source(interpreter, &print_words, &node->words[1], node->word_count - 1);
+        interpreter->print_words = &print_words;
+        interpreter->args = arena_alloc(2 * sizeof(char *));
+        interpreter->args[0] = node->words[0].text;
+        interpreter->args[1] = NULL;
+        interpreter->arg_count = 1;
+    } else if (expand_tokens(interpreter, node->words, node->word_count) < 0) { //fill the arguments with the expanded words
+        set_exit_code(EXIT_FAILURE);
+        return 0;
+    }
+
+    //checking for VAR=VALUE, the value is the rest of the command
+    int equals_position = check_for_char_in_string(interpreter->args[0], (int) strlen(interpreter->args[0]), '=');
+
+    //if VAR=VALUE, either set an existing variable or create a new one
+    if (equals_position != -1 && equals_position != 0) {
+        size_t command_length = 0;
+        for (int i = 0; i < interpreter->arg_count; i++) {
+            command_length += strlen(interpreter->args[i]) + 1;
+        }
+
+        char *command = arena_alloc(command_length);
+        command[0] = '\0';
+        for (int i = 0; i < interpreter->arg_count; i++) {
+            strcat(command, interpreter->args[i]);
+            strcat(command, i < interpreter->arg_count - 1 ? " " : "");
+        }
+
+        set_variable(command, (int) strlen(command), equals_position);
+        return 0;
+    }
+
+    //open the files of all the redirections before the command is run
+    struct redirection_plan plan;
+    if (prepare_redirections(interpreter, node->redirections, &plan) != 0) {
+        interpreter->print_words = NULL;
+        set_exit_code(EXIT_FAILURE);
+        return 0;
+    }
+
+    int exit_terminal = execute_command(interpreter, &plan);
+    interpreter->print_words = NULL;
+
+    close_redirection_files(&plan);
+
+    return exit_terminal;
+}
+
+//function which checks if a command is the 'print' command, whose words are expanded as they are printed
+//a function called print replaces the command, so it gets its arguments expanded like any other function
+//the files of redirections are opened before the words are printed, so with redirections a word with a glob or a $
+//is expanded first, like the words of other commands, so that a glob does not match a file the redirection creates
+//and the errors of $(...) are not written to the file, words such as {1..100000} are still printed as they are made
+//returns 1 if it is, returns 0 otherwise
+int is_lazy_print(const struct node *node) {
+    if (node->words[0].flags != 0 || strcasecmp(node->words[0].text, "print") != 0 ||
+        find_function(node->words[0].text) != NULL) {
+        return 0;
+    }
+
+    for (int i = 1; i < node->word_count; i++) {
+        if (node->redirections != NULL && (node->words[i].flags & (WORD_GLOB | WORD_DOLLAR))) {
+            return 0;
+        }
+
+        //a $((...)) which cannot be evaluated stops the command, so it is evaluated before anything is printed
+        if ((node->words[i].flags & WORD_DOLLAR) && memmem(node->words[i].text, (size_t) node->words[i].length,
+                                                           "$((", 3) != NULL) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+//function which sets EXITCODE and the string returned for the variable
+void set_exit_code(int exit_code) {
+    EXITCODE = exit_code;
+
+    sprintf(EXITCODE_S, "%d", EXITCODE);
+}
+
+//function to check if the input contains an a certain character
+//returns a -1 if no character is found, else returns the position of the character
+int check_for_char_in_string(const char input[], int input_length, char check_char) {
+    int char_position = -1;
+
+    for (int i = 0; i < input_length; i++) {
+        if (input[i] == check_char) {
+            char_position = i;
+            break;
+        }
+    }
+
+    return char_position;
+}
+
+//function to check whether a user created variable is valid
+//returns 0 if invalid and 1 if valid
+int check_var_name_validity(const char input[], int input_length) {
+    int valid = 1;
+
+    for (int i = 0; i < input_length; i++) {
+        if (input[i] >= 48 && input[i] <= 57) {
+            valid = 1;
+        } else if (input[i] >= 65 && input[i] <= 90) {
+            valid = 1;
+        } else if (input[i] >= 97 && input[i] <= 122) {
+            valid = 1;
+        } else if (input[i] == '_') {
+            valid = 1;
+        } else {
+            valid = 0;
+            break;
+        }
+    }
+
+    return valid;
+}
+
+//function which finds a variable in the variable store
+//returns the variable, or NULL if there is no variable with that name
+struct variable *find_variable(const char name[], size_t length) {
+    if (VARIABLE_CAPACITY == 0) {
+        return NULL;
+    }
+
+    unsigned int hash = hash_bytes(name, length);
+
+    //move to the next slot until the variable or an empty slot is found
+    for (size_t i = hash & (VARIABLE_CAPACITY - 1); VARIABLES[i] != NULL; i = (i + 1) & (VARIABLE_CAPACITY - 1)) {
+        if (VARIABLES[i]->hash == hash && strncmp(VARIABLES[i]->name, name, length) == 0 &&
+            VARIABLES[i]->name[length] == '\0') {
+            return VARIABLES[i];
+        }
+    }
+
+    return NULL;
+}
+
+//function which adds a variable with an empty value to the variable store
+//the table is doubled when it is half full, so that the slots stay short
+//returns the new variable
+struct variable *add_variable(const char name[], size_t length, int flags) {
+    if ((VARIABLE_COUNT + 1) * 2 > VARIABLE_CAPACITY) {
+        size_t new_capacity = VARIABLE_CAPACITY == 0 ? 64 : VARIABLE_CAPACITY * 2;
+        struct variable **new_variables = calloc(new_capacity, sizeof(struct variable *));
+
+        //put every variable in its slot in the new table
+        for (size_t i = 0; i < VARIABLE_COUNT; i++) {
+            size_t slot = VARIABLE_ORDER[i]->hash & (new_capacity - 1);
+            while (new_variables[slot] != NULL) {
+                slot = (slot + 1) & (new_capacity - 1);
+            }
+            new_variables[slot] = VARIABLE_ORDER[i];
+        }
+
+        free(VARIABLES);
+        VARIABLES = new_variables;
+        VARIABLE_CAPACITY = new_capacity;
+        VARIABLE_ORDER = realloc(VARIABLE_ORDER, new_capacity / 2 * sizeof(struct variable *));
+    }
+
+    struct variable *variable = calloc(1, sizeof(struct variable) + length + 1);
+    memcpy(variable->name, name, length);
+    variable->hash = hash_bytes(name, length);
+    variable->value = "";
+    variable->flags = flags;
+    variable->env_index = -1;
+
+    size_t slot = variable->hash & (VARIABLE_CAPACITY - 1);
+    while (VARIABLES[slot] != NULL) {
+        slot = (slot + 1) & (VARIABLE_CAPACITY - 1);
+    }
+    VARIABLES[slot] = variable;
+    VARIABLE_ORDER[VARIABLE_COUNT++] = variable;
+
+    return variable;
+}
+
+//function which copies a value into a variable, growing the value if it does not fit
+//the global of a shell variable is updated to point to the new value
+void store_variable_value(struct variable *variable, const char value[]) {
+    size_t length = strlen(value);
+
+    if (length + 1 > variable->capacity) {
+        size_t capacity = variable->capacity == 0 ? 16 : variable->capacity;
+        while (capacity < length + 1) {
+            capacity *= 2;
+        }
+
+        variable->value = realloc(variable->capacity == 0 ? NULL : variable->value, capacity);
+        variable->capacity = capacity;
+    }
+
+    memmove(variable->value, value, length + 1);
+    variable->flags &= ~(VARIABLE_INTEGER | VARIABLE_STALE);
+
+    if (variable->global != NULL) {
+        *variable->global = variable->value;
+    }
+}
+
+//function which returns the value of a variable, working it out first if it is stale, such as CWD after a chdir
+char *variable_value(struct variable *variable) {
+    if (variable->flags & VARIABLE_STALE) {
+        variable->on_get(variable);
+    }
+
+    return variable->value;
+}
+
+//function which changes the value of a variable as if VAR=VALUE was entered
+//returns 0 if the value was changed, returns 1 otherwise
+int set_variable_value(struct variable *variable, const char value[]) {
+    if (variable->flags & VARIABLE_READONLY) {
+        printf("Cannot set variable %s.\n", variable->name);
+        return 1;
+    }
+
+    //shell variables such as CWD and PATH may need to change more than the value
+    if (variable->on_set != NULL && variable->on_set(value) != 0) {
+        return 1;
+    }
+
+    store_variable_value(variable, value);
+    variable->flags &= ~VARIABLE_INHERITED;
+
+    //only the entry of this variable is rebuilt if it is exported
+    update_environment_entry(variable);
+
+    return 0;
+}
+
+//function which gets the value of a variable as a number, used by $((...))
+//the number is kept in the variable, so it is only parsed again once the value changes
+//an empty value is 0
+//returns 0 if the value is a number, returns 1 otherwise
+int get_variable_integer(struct variable *variable, long long *value) {
+    if (variable->flags & VARIABLE_INTEGER) {
+        *value = variable->integer;
+        return 0;
+    }
+
+    char *end;
+    errno = 0;
+    long long number = strtoll(variable_value(variable), &end, 0);
+    while (*end == ' ' || *end == '\t') {
+        end++;
+    }
+    if (errno != 0 || *end != '\0') {
+        return 1;
+    }
+
+    //the buffers of read-only variables such as EXITCODE are changed by the shell directly, so they are not kept
+    if (!(variable->flags & VARIABLE_READONLY)) {
+        variable->integer = number;
+        variable->flags |= VARIABLE_INTEGER;
+    }
+
+    *value = number;
+    return 0;
+}
+
+//function which sets a variable to a number, keeping the number so that it does not have to be parsed again
+//returns 0 if the value was changed, returns 1 otherwise
+int set_variable_integer(struct variable *variable, long long value) {
+    char text[32];
+    snprintf(text, sizeof(text), "%lld", value);
+
+    if (set_variable_value(variable, text) != 0) {
+        return 1;
+    }
+
+    variable->integer = value;
+    variable->flags |= VARIABLE_INTEGER;
+
+    return 0;
+}
+
+//function which adds a shell variable whose value is also kept in a global such as PATH
+//returns the new variable
+struct variable *add_shell_variable(const char name[], char **global, const char value[], int flags,
+                                    int (*on_set)(const char value[])) {
+    struct variable *variable = add_variable(name, strlen(name), flags & ~VARIABLE_EXPORTED);
+
+    variable->global = global;
+    variable->on_set = on_set;
+
+    store_variable_value(variable, value);
+
+    if (flags & VARIABLE_EXPORTED) {
+        export_variable(variable);
+    }
+
+    return variable;
+}
+
+//function which adds a shell variable whose value is worked out by on_get when it is first read, such as CWD
+//so that the shell does not look up values at startup which may never be used
+void add_computed_variable(const char name[], char **global, int (*on_set)(const char value[]),
+                           void (*on_get)(struct variable *variable)) {
+    struct variable *variable = add_shell_variable(name, global, "", 0, on_set);
+
+    variable->on_get = on_get;
+    variable->flags |= VARIABLE_STALE;
+}
+
+//function which adds a variable whose value is a buffer which the shell keeps up to date, such as EXITCODE
+void add_readonly_variable(const char name[], char value[]) {
+    struct variable *variable = add_variable(name, strlen(name), VARIABLE_READONLY);
+
+    variable->value = value;
+}
+
+//function which adds every variable in the environment of the shell which is not a shell variable
+void import_environment() {
+    for (int i = 0; environ[i] != NULL; i++) {
+        char *equals = strchr(environ[i], '=');
+
+        if (equals == NULL || equals == environ[i] || find_variable(environ[i], (size_t) (equals - environ[i])) != NULL) {
+            continue;
+        }
+
+        struct variable *variable = add_variable(environ[i], (size_t) (equals - environ[i]), VARIABLE_INHERITED);
+        store_variable_value(variable, equals + 1);
+        export_variable(variable);
+    }
+}
+
+//function which marks a variable as exported and adds its NAME=VALUE entry to ENVP
+void export_variable(struct variable *variable) {
+    variable->flags |= VARIABLE_EXPORTED;
+
+    if (variable->env_index >= 0) {
+        return;
+    }
+
+    //ENVP always has space for the NULL at the end
+    if (ENVP_COUNT + 2 > ENVP_CAPACITY) {
+        ENVP_CAPACITY = ENVP_CAPACITY == 0 ? 64 : ENVP_CAPACITY * 2;
+        ENVP = realloc(ENVP, ENVP_CAPACITY * sizeof(char *));
+        ENVP_VARIABLES = realloc(ENVP_VARIABLES, ENVP_CAPACITY * sizeof(struct variable *));
+    }
+
+    variable->env_index = (int) ENVP_COUNT;
+    ENVP_VARIABLES[ENVP_COUNT] = variable;
+    ENVP_COUNT++;
+
+    update_environment_entry(variable);
+}
+
+//function which rebuilds the NAME=VALUE entry of an exported variable after its value changes
+void update_environment_entry(struct variable *variable) {
+    if (variable->env_index < 0) {
+        return;
+    }
+
+    size_t name_length = strlen(variable->name);
+    size_t value_length = strlen(variable_value(variable));
+
+    variable->env_entry = realloc(variable->env_entry, name_length + value_length + 2);
+    memcpy(variable->env_entry, variable->name, name_length);
+    variable->env_entry[name_length] = '=';
+    memcpy(&variable->env_entry[name_length + 1], variable->value, value_length + 1);
+
+    ENVP[variable->env_index] = variable->env_entry;
+    ENVP[ENVP_COUNT] = NULL;
+}
+
+//function which removes the entry of a variable from ENVP, the last entry is moved into its place
+void remove_environment_entry(struct variable *variable) {
+    if (variable->env_index < 0) {
+        return;
+    }
+
+    ENVP_COUNT--;
+    ENVP[variable->env_index] = ENVP[ENVP_COUNT];
+    ENVP_VARIABLES[variable->env_index] = ENVP_VARIABLES[ENVP_COUNT];
+    ENVP_VARIABLES[variable->env_index]->env_index = variable->env_index;
+    ENVP[ENVP_COUNT] = NULL;
+
+    free(variable->env_entry);
+    variable->env_entry = NULL;
+    variable->env_index = -1;
+    variable->flags &= ~VARIABLE_EXPORTED;
+}
+
+//function which removes a variable from the variable store and frees it
+//the variables after it in the same run of slots are moved back, so that no slot is left marked as deleted
+void remove_variable(struct variable *variable) {
+    size_t mask = VARIABLE_CAPACITY - 1;
+    size_t slot = variable->hash & mask;
+
+    while (VARIABLES[slot] != variable) {
+        slot = (slot + 1) & mask;
+    }
+
+    VARIABLES[slot] = NULL;
+    for (size_t next = (slot + 1) & mask; VARIABLES[next] != NULL; next = (next + 1) & mask) {
+        size_t home = VARIABLES[next]->hash & mask;
+
+        //move the variable into the empty slot if the empty slot is between its home slot and its current slot
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            VARIABLES[slot] = VARIABLES[next];
+            VARIABLES[next] = NULL;
+            slot = next;
+        }
+    }
+
+    for (size_t i = 0; i < VARIABLE_COUNT; i++) {
+        if (VARIABLE_ORDER[i] == variable) {
+            memmove(&VARIABLE_ORDER[i], &VARIABLE_ORDER[i + 1], (VARIABLE_COUNT - i - 1) * sizeof(struct variable *));
+            break;
+        }
+    }
+    VARIABLE_COUNT--;
+
+    remove_environment_entry(variable);
+    if (variable->capacity != 0) {
+        free(variable->value);
+    }
+    free(variable);
+}
+
+//function which exports the given variables, 'export NAME=VALUE' also sets the value first
+//without arguments, every exported variable is printed
+//returns 0 if every variable was exported, returns 1 otherwise
+int export_command(struct interpreter *interpreter) {
+    int exit_code = 0;
+
+    if (interpreter->arg_count == 1) {
+        for (size_t i = 0; i < ENVP_COUNT; i++) {
+            printf("export %s\n", ENVP[i]);
+        }
+        return 0;
+    }
+
+    for (int i = 1; i < interpreter->arg_count; i++) {
+        char *equals = strchr(interpreter->args[i], '=');
+        size_t name_length = equals != NULL ? (size_t) (equals - interpreter->args[i]) : strlen(interpreter->args[i]);
+
+        if (name_length == 0 || check_var_name_validity(interpreter->args[i], (int) name_length) == 0) {
+            printf("export: %s: invalid variable name\n", interpreter->args[i]);
+            exit_code = EXIT_FAILURE;
+            continue;
+        }
+
+        struct variable *variable = find_variable(interpreter->args[i], name_length);
+        if (variable == NULL) {
+            variable = add_variable(interpreter->args[i], name_length, 0);
+        }
+
+        if (variable->flags & VARIABLE_READONLY) {
+            printf("export: %s: cannot export variable\n", variable->name);
+            exit_code = EXIT_FAILURE;
+        } else if (equals != NULL && set_variable_value(variable, equals + 1) != 0) {
+            exit_code = EXIT_FAILURE;
+        } else {
+            export_variable(variable);
+        }
+    }
+
+    return exit_code;
+}
+
+//function which removes the given user created variables, shell variables cannot be removed
+//returns 0 if every variable was removed or did not exist, returns 1 otherwise
+int unset_command(struct interpreter *interpreter) {
+    int exit_code = 0;
+
+    if (interpreter->arg_count == 1) {
+        printf("Invalid input!\n");
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 1; i < interpreter->arg_count; i++) {
+        struct variable *variable = find_variable(interpreter->args[i], strlen(interpreter->args[i]));
+
+        if (variable == NULL) {
+            continue;
+        } else if (variable->global != NULL || (variable->flags & VARIABLE_READONLY)) {
+            printf("unset: %s: cannot unset shell variable\n", variable->name);
+            exit_code = EXIT_FAILURE;
+        } else {
+            remove_variable(variable);
+        }
+    }
+
+    return exit_code;
+}
+
+//function which is called before PATH is changed
+//returns 0 so that the value is always changed
+int on_set_path(const char value[]) {
+    //the new value is not needed, the remembered command locations are simply not valid for it
+    (void) value;
+    clear_command_hash();
+
+    return 0;
+}
+
+//function which is called before CWD is changed, the value is only changed if the directory exists
+//returns 0 if the directory was changed, returns 1 otherwise
+int on_set_cwd(const char value[]) {
+    if (chdir(value) != 0) {
+        perror("Cannot change directory");
+        return 1;
+    }
+
+    return 0;
+}
+
+//function which sets CWD to the current working directory of the shell, called when CWD is read after a chdir
+void get_cwd_value(struct variable *variable) {
+    char *cwd = getcwd(NULL, 0);
+
+    if (cwd == NULL) {
+        perror("Cannot set current working directory");
+        store_variable_value(variable, "");
+        return;
+    }
+
+    store_variable_value(variable, cwd);
+    free(cwd);
+}
+
+//function which is called after the shell changes directory, CWD is looked up again the next time it is read
+void invalidate_cwd() {
+    struct variable *variable = find_variable("CWD", strlen("CWD"));
+
+    variable->flags |= VARIABLE_STALE;
+
+    //an exported CWD is passed on to commands, so its entry is rebuilt straight away
+    update_environment_entry(variable);
+}
+
+//function which sets TERMINAL to the name of the terminal of the shell, empty if the shell is not interactive
+//the name is looked up again the next time if the input is not the terminal at the moment, such as in a redirected loop
+void get_terminal_value(struct variable *variable) {
+    char name[MAX_LENGTH];
+
+    if (!INTERACTIVE) {
+        store_variable_value(variable, "");
+    } else if (ttyname_r(STDIN_FILENO, name, sizeof(name)) == 0) {
+        store_variable_value(variable, name);
+    } else {
+        store_variable_value(variable, "");
+        variable->flags |= VARIABLE_STALE;
+    }
+}
+
+//function which edits a current variable ot adds a user created
+//variable if VAR=VALUE is entered
+void set_variable(const char input[], int input_length, int equals_position) {
+    //check if the variable name is valid
+    if (check_var_name_validity(input, equals_position) == 0) {
+        printf("Invalid variable name.\n");
+        return;
+    }
+
+    //check if the value of the variable is left empty
+    if (equals_position == input_length - 1) {
+        printf("Invalid variable value.\n");
+        return;
+    }
+
+    //if the variable does not exist, add a new user created variable, which is only passed on if it is exported
+    struct variable *variable = find_variable(input, (size_t) equals_position);
+    if (variable == NULL) {
+        variable = add_variable(input, (size_t) equals_position, 0);
+    }
+
+    //any $VAR in the value has already been expanded
+    set_variable_value(variable, &input[equals_position + 1]);
+}
+
+//function which takes a string as an input and checks
+//if that string is a variable which has a corresponding value
+//if the variable name is found, its value is returned
+char *get_variable_value(const char var_name[]) {
+    struct variable *variable = find_variable(var_name, strlen(var_name));
+
+    return variable != NULL ? variable_value(variable) : "";
+}
+
+//function which clears the given string
+void clear_string(char input[], int input_length) {
+    if (input_length > 0) {
+        for (int i = 0; i < input_length; i++) {
+            input[i] = '\0';
+        }
+    }
+}
+
+//function which prints all the standard variables
+void print_standard_variables() {
+    for (size_t i = 0; i < VARIABLE_COUNT; i++) {
+        if (VARIABLE_ORDER[i]->global != NULL || (VARIABLE_ORDER[i]->flags & VARIABLE_READONLY)) {
+            printf("%s=%s\n", VARIABLE_ORDER[i]->name, variable_value(VARIABLE_ORDER[i]));
+        }
+    }
+}
+
+//function which prints all the user created variables
+void print_user_variables() {
+    for (size_t i = 0; i < VARIABLE_COUNT; i++) {
+        if (VARIABLE_ORDER[i]->global == NULL &&
+            !(VARIABLE_ORDER[i]->flags & (VARIABLE_READONLY | VARIABLE_INHERITED))) {
+            printf("%s=%s \n", VARIABLE_ORDER[i]->name, VARIABLE_ORDER[i]->value);
+        }
+    }
+}
+
+//function which splits an input string into words and operators in a single pass
+//quotes and backslashes are kept in the words and removed when the words are expanded,
+//the words are terminated in place so that they do not need to be copied
+//returns 0 if the input is valid, returns 1 if a quote is not closed
+int tokenise_input(char input[], struct token_list *list) {
+    int i = 0;
+
+    list->count = 0;
+
+    while (input[i] != '\0') {
+        //skip spaces and tabs between tokens
+        if (input[i] == ' ' || input[i] == '\t') {
+            i++;
+            continue;
+        }
+
+        const struct operator *operator = match_operator(&input[i]);
+        if (operator != NULL) {
+            add_token(list, operator->type, (char *) operator->text, operator->length, 0);
+            i += operator->length;
+            continue;
+        }
+
+        //read a word up to the next space, tab or operator outside quotes
+        int start = i;
+        int flags = 0;
+
+        while (input[i] != '\0' && input[i] != ' ' && input[i] != '\t' && match_operator(&input[i]) == NULL) {
+            if (input[i] == '\\') {
+                flags |= WORD_ESCAPED;
+                i += input[i + 1] != '\0' ? 2 : 1;
+            } else if (input[i] == '\'') {
+                flags |= WORD_QUOTED;
+                char *closing_quote = strchr(&input[i + 1], '\'');
+                if (closing_quote == NULL) {
+                    printf("Missing closing quote.\n");
+                    return 1;
+                }
+                i = (int) (closing_quote - input) + 1;
+            } else if (input[i] == '"') {
+                flags |= WORD_QUOTED;
+                i++;
+                while (input[i] != '"') {
+                    if (input[i] == '\0') {
+                        printf("Missing closing quote.\n");
+                        return 1;
+                    } else if (input[i] == '\\' && input[i + 1] != '\0') {
+                        flags |= WORD_ESCAPED;
+                        i++;
+                    } else if (input[i] == '$' && input[i + 1] == '(') {
+                        flags |= WORD_DOLLAR;
+                        i = find_substitution_end(input, i + 1);
+                        if (i < 0) {
+                            printf("Missing closing bracket.\n");
+                            return 1;
+                        }
+                    } else if (input[i] == '$') {
+                        flags |= WORD_DOLLAR;
+                    }
+                    i++;
+                }
+                i++;
+            } else if (input[i] == '$' && input[i + 1] == '(') {
+                //the command of a $(...) substitution is part of the word, even if it has spaces or operators
+                flags |= WORD_DOLLAR;
+                i = find_substitution_end(input, i + 1);
+                if (i < 0) {
+                    printf("Missing closing bracket.\n");
+                    return 1;
+                }
+                i++;
+            } else {
+                if (input[i] == '$') {
+                    flags |= WORD_DOLLAR;
+                } else if (input[i] == '*' || input[i] == '?' || input[i] == '[') {
+                    flags |= WORD_GLOB;
+                } else if (input[i] == '{' && (i == start || input[i - 1] != '$')) {
+                    flags |= WORD_BRACE;
+                }
+                i++;
+            }
+        }
+
+        //digits straight before '<' or '>' are the file descriptor which is redirected
+        enum token_type type = TOKEN_WORD;
+        if ((input[i] == '<' || input[i] == '>') && flags == 0 && strspn(&input[start], "0123456789") == (size_t) (i - start)) {
+            type = TOKEN_IO_NUMBER;
+        }
+
+        add_token(list, type, &input[start], i - start, flags);
+
+        //terminate the word, an operator straight after it is added before its first character is overwritten
+        if (input[i] == ' ' || input[i] == '\t') {
+            input[i] = '\0';
+            i++;
+        } else if (input[i] != '\0') {
+            operator = match_operator(&input[i]);
+            input[i] = '\0';
+            add_token(list, operator->type, (char *) operator->text, operator->length, 0);
+            i += operator->length;
+        }
+    }
+
+    return 0;
+}
+
+//function which checks if the input starts with an operator
+//returns the operator, or NULL if there is none
+const struct operator *match_operator(const char input[]) {
+    //most characters cannot start an operator, so check for those first
+    if (input[0] != ';' && input[0] != '&' && input[0] != '|' && input[0] != '>' && input[0] != '<') {
+        return NULL;
+    }
+
+    for (int i = 0; i < NUM_OPERATORS; i++) {
+        if (strncmp(input, OPERATORS[i].text, (size_t) OPERATORS[i].length) == 0) {
+            return &OPERATORS[i];
+        }
+    }
+
+    return NULL;
+}
+
+//function which adds a token to the end of a token list, growing the list if it is full
+void add_token(struct token_list *list, enum token_type type, char *text, int length, int flags) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+        list->tokens = arena_grow(list->tokens, list->capacity * sizeof(struct token), capacity * sizeof(struct token));
+        list->capacity = capacity;
+    }
+
+    list->tokens[list->count].type = type;
+    list->tokens[list->count].text = text;
+    list->tokens[list->count].length = length;
+    list->tokens[list->count].flags = flags;
+    list->count++;
+}
+
+//function which expands a word into the line arena, removing quotes and backslashes and replacing $VAR
+//text in single quotes is kept as it is, and a variable which is not found is kept as $VAR
+//words without quotes, backslashes or $ are returned as they are without being copied
+//returns the expanded word
+char *expand_word(struct interpreter *interpreter, const struct token *token) {
+    if (token->flags == 0) {
+        return token->text;
+    }
+
+    return expand_word_text(interpreter, token, 0);
+}
+
+//function which does the expansion of expand_word
+//if glob_pattern is 1, the word is made into a glob pattern instead
+//then only *, ? and [ typed outside quotes are wildcards, and the other ones are escaped with a backslash
+//returns the expanded word
+char *expand_word_text(struct interpreter *interpreter, const struct token *token, int glob_pattern) {
+    size_t capacity = (size_t) token->length + 1;
+    size_t length = 0;
+    char *word = arena_alloc(capacity);
+    int here_document = token->flags & WORD_HERE_DOCUMENT;
+    int in_double_quotes = here_document;
+
+    for (int i = 0; i < token->length; i++) {
+        char current = token->text[i];
+        const char *append = NULL;
+        size_t append_length = 0;
+        int wildcard = 0;
+
+        if (current == '\'' && !in_double_quotes) {
+            //copy everything up to the closing quote as it is
+            char *closing_quote = strchr(&token->text[i + 1], '\'');
+            append = &token->text[i + 1];
+            append_length = (size_t) (closing_quote - append);
+            i += (int) append_length + 1;
+        } else if (current == '"' && !here_document) {
+            in_double_quotes = !in_double_quotes;
+        } else if (current == '\\' && i + 1 < token->length) {
+            //inside double quotes a backslash only escapes $, ", ` and another backslash, in a here-document " is not escaped
+            char next = token->text[i + 1];
+            if (in_double_quotes && next != '$' && (next != '"' || here_document) && next != '`' && next != '\\') {
+                append = &token->text[i];
+                append_length = 2;
+            } else {
+                append = &token->text[i + 1];
+                append_length = 1;
+            }
+            i++;
+        } else if (current == '$' && token->text[i + 1] == '(' && token->text[i + 2] == '(' &&
+                   find_substitution_end(token->text, i + 2) > 0 &&
+                   token->text[find_substitution_end(token->text, i + 2) + 1] == ')') {
+            //replace $((...)) with the value of the expression inside the brackets
+            int end = find_substitution_end(token->text, i + 2);
+            append = arithmetic_expansion(interpreter, &token->text[i + 3], (size_t) (end - i - 3), &append_length);
+            i = end + 1;
+        } else if (current == '$' && token->text[i + 1] == '(' && find_substitution_end(token->text, i + 1) > 0) {
+            //replace $(...) with the output of the command inside the brackets
+            int end = find_substitution_end(token->text, i + 1);
+            append = command_substitution(interpreter, &token->text[i + 2], (size_t) (end - i - 2), &append_length);
+            i = end;
+        } else if (current == '$' && interpreter->positional != NULL && is_positional_parameter(&token->text[i + 1])) {
+            //replace $0 to $N and $# with the arguments of the function being called
+            int name_length;
+            append = get_positional_parameter(interpreter, &token->text[i + 1], &name_length);
+            append_length = strlen(append);
+            i += name_length;
+        } else if (current == '$') {
+            //get the name after the $, which is either written as $NAME or ${NAME}
+            int braces = token->text[i + 1] == '{';
+            int name_start = i + 1 + braces;
+            int name_end = name_start;
+
+            while (name_end < token->length && check_var_name_validity(&token->text[name_end], 1)) {
+                name_end++;
+            }
+
+            struct variable *variable = NULL;
+            if (name_end > name_start && (!braces || token->text[name_end] == '}')) {
+                variable = find_variable(&token->text[name_start], (size_t) (name_end - name_start));
+            }
+
+            if (name_end == name_start || (braces && token->text[name_end] != '}')) {
+                //a $ which is not followed by a name is kept as it is
+                append = &token->text[i];
+                append_length = 1;
+            } else {
+                //a variable which is not found or is empty is kept as it was entered
+                if (variable != NULL && variable_value(variable)[0] != '\0') {
+                    append = variable->value;
+                    append_length = strlen(append);
+                } else {
+                    append = &token->text[i];
+                    append_length = (size_t) (name_end + braces - i);
+                }
+                i = name_end - 1 + braces;
+            }
+        } else {
+            append = &token->text[i];
+            append_length = 1;
+            wildcard = !in_double_quotes;
+        }
+
+        if (append_length == 0) {
+            continue;
+        }
+
+        //variables can make the word longer than the token, so the word is grown when needed
+        //in a glob pattern every character may need a backslash in front of it
+        size_t needed = length + (glob_pattern ? 2 * append_length : append_length) + 1;
+        if (needed > capacity) {
+            size_t new_capacity = capacity * 2 > needed ? capacity * 2 : needed;
+            word = arena_grow(word, capacity, new_capacity);
+            capacity = new_capacity;
+        }
+
+        if (glob_pattern && !wildcard) {
+            for (size_t j = 0; j < append_length; j++) {
+                if (strchr("*?[]\\", append[j]) != NULL) {
+                    word[length++] = '\\';
+                }
+                word[length++] = append[j];
+            }
+        } else {
+            memcpy(&word[length], append, append_length);
+            length += append_length;
+        }
+    }
+
+    word[length] = '\0';
+
+    return word;
+}
+
+//function which finds the ')' which closes a $( substitution, skipping quotes and nested brackets
+//start is the position of the '('
+//returns the position of the ')', or -1 if the substitution is not closed
+int find_substitution_end(const char input[], int start) {
+    int depth = 0;
+
+    for (int i = start; input[i] != '\0'; i++) {
+        if (input[i] == '\\' && input[i + 1] != '\0') {
+            i++;
+        } else if (input[i] == '\'') {
+            char *closing_quote = strchr(&input[i + 1], '\'');
+            if (closing_quote == NULL) {
+                return -1;
+            }
+            i = (int) (closing_quote - input);
+        } else if (input[i] == '"') {
+            for (i++; input[i] != '"'; i++) {
+                if (input[i] == '\0') {
+                    return -1;
+                } else if (input[i] == '\\' && input[i + 1] != '\0') {
+                    i++;
+                }
+            }
+        } else if (input[i] == '(') {
+            depth++;
+        } else if (input[i] == ')' && --depth == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+//function which runs the command of a $(...) substitution and returns its output without the trailing new lines
+//commands made only of builtins which print are run in the shell with STDOUT written to memory
+//anything else is run in a forked copy of the shell, and its output is read through a pipe
+//the exit code of the command is stored in EXITCODE
+//returns the output, allocated from the line arena
+char *command_substitution(struct interpreter *interpreter, const char command[], size_t length,
+                           size_t *output_length) {
+    struct interpreter frame;
+    char *output = NULL;
+    size_t size = 0;
+    int position = 0;
+    struct token_list list = {NULL, 0, 0};
+
+    //the copy is made before the mark, since the lexer terminates the words inside it
+    char *line = arena_strndup(command, length);
+    struct arena_mark mark = arena_get_mark();
+
+    //the command runs in a frame of its own, so the arguments of the command being expanded are left as they are
+    start_interpreter_frame(&frame, interpreter);
+
+    struct node *tree = NULL;
+    if (tokenise_input(line, &list) == 0 && list.count > 0) {
+        tree = parse_list(list.tokens, list.count, &position);
+        if (tree == NULL && PARSE_INCOMPLETE) {
+            //a command substitution cannot go on to the next line
+            PARSE_INCOMPLETE = 0;
+            print_syntax_error(list.tokens, list.count, list.count);
+        } else if (tree != NULL && position < list.count) {
+            print_syntax_error(list.tokens, list.count, position);
+            tree = NULL;
+        }
+    }
+
+    if (tree == NULL) {
+        set_exit_code(list.count > 0 ? EXIT_FAILURE : 0);
+    } else if (substitution_runs_in_shell(tree)) {
+        //the builtins print through stdout, so it is swapped with a stream which writes to memory
+        FILE *saved_stdout = stdout;
+        FILE *stream = open_memstream(&output, &size);
+        if (stream == NULL) {
+            perror("Unable to capture output");
+            set_exit_code(EXIT_FAILURE);
+        } else {
+            fflush(stdout);
+            stdout = stream;
+            evaluate_node(&frame, tree);
+            fclose(stream);
+            stdout = saved_stdout;
+        }
+    } else {
+        int output_pipe[2];
+        pid_t pid;
+
+        fflush(stdout);
+        if (pipe2(output_pipe, O_CLOEXEC) != 0) {
+            perror("Unable to create pipe");
+            set_exit_code(EXIT_FAILURE);
+        } else if ((pid = fork()) < 0) {
+            perror("Unable to fork");
+            close(output_pipe[0]);
+            close(output_pipe[1]);
+            set_exit_code(EXIT_FAILURE);
+        } else if (pid == 0) {
+            //the copy of the shell runs the command with STDOUT going to the pipe
+            //in a $(...) which runs in the shell, stdout is still the memory stream of that one, which the copy
+            //would throw away, so the builtins of the copy print through the stdout of the process again
+            dup2(output_pipe[1], STDOUT_FILENO);
+            stdout = REAL_STDOUT;
+            evaluate_node(&frame, tree);
+            fflush(stdout);
+            _exit(EXITCODE);
+        } else {
+            close(output_pipe[1]);
+
+            //read until the command and everything it started has closed the pipe
+            size_t capacity = 0;
+            ssize_t bytes_read = 1;
+            while (bytes_read != 0) {
+                if (size + BUFSIZ > capacity) {
+                    capacity = capacity == 0 ? BUFSIZ : capacity * 2;
+                    output = realloc(output, capacity);
+                    if (output == NULL) {
+                        perror("Unable to allocate memory");
+                        exit(EXIT_FAILURE);
+                    }
+                }
+
+                bytes_read = read(output_pipe[0], &output[size], capacity - size);
+                if (bytes_read > 0) {
+                    size += (size_t) bytes_read;
+                } else if (bytes_read < 0 && errno != EINTR) {
+                    break;
+                }
+            }
+            close(output_pipe[0]);
+
+            int wait_val;
+            waitpid(pid, &wait_val, 0);
+            set_exit_code(wait_status_to_exit_code(wait_val));
+        }
+    }
+
+    arena_release(mark);
+
+    //the directories read before may have been changed by the command, and the ones read by it are released
+    GLOB_CACHE = NULL;
+
+    //trailing new lines are removed from the output
+    while (size > 0 && output[size - 1] == '\n') {
+        size--;
+    }
+
+    char *result = arena_strndup(output != NULL ? output : "", size);
+    free(output);
+    *output_length = size;
+
+    return result;
+}
+
+//function which checks if a substitution can be run in the shell without forking
+//this is the case when every command is a builtin which only prints, or a function whose body only runs such
+//builtins, with no pipes or redirections
+//returns 1 if it can be run in the shell, returns 0 otherwise
+int substitution_runs_in_shell(struct node *node) {
+    static const char *printing_commands[] = {"print", "all", "hash", "jobs", "times"};
+
+    if (node == NULL) {
+        return 1;
+    }
+
+    //a for loop sets its variable and a definition adds a function, which must not change the shell
+    if (node->type != NODE_COMMAND) {
+        return node->type != NODE_PIPE && node->type != NODE_FOR && node->type != NODE_FUNCTION &&
+               substitution_runs_in_shell(node->left) &&
+               substitution_runs_in_shell(node->right) && substitution_runs_in_shell(node->else_branch);
+    }
+
+    if (node->background || node->timed || node->redirections != NULL || node->words[0].flags != 0) {
+        return 0;
+    }
+
+    //functions are run before builtins, so a function called print is checked by its body
+    //a recursive call adds no other commands, so the body is only checked by the outermost call
+    struct function *function = find_function(node->words[0].text);
+    if (function != NULL) {
+        if (function->checking) {
+            return 1;
+        }
+
+        function->checking = 1;
+        int runs_in_shell = substitution_runs_in_shell(function->body);
+        function->checking = 0;
+
+        return runs_in_shell;
+    }
+
+    for (size_t i = 0; i < sizeof(printing_commands) / sizeof(printing_commands[0]); i++) {
+        if (strcasecmp(node->words[0].text, printing_commands[i]) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+//function which evaluates the expression of a $((...)) expansion in the shell
+//the C integer operators are supported with their usual precedence, including assignments such as 'i += 1'
+//variables are written with or without a $, and a variable which is not set is 0
+//if the expression is not valid an error is printed, EXITCODE is set and the result is empty
+//returns the value as text, allocated from the line arena
+char *arithmetic_expansion(struct interpreter *interpreter, const char expression[], size_t length,
+                           size_t *output_length) {
+    struct arithmetic state = {interpreter, arena_strndup(expression, length), 0, 0, 0};
+
+    long long value = evaluate_arithmetic_assignment(&state);
+
+    skip_arithmetic_spaces(&state);
+    if (!state.error && state.text[state.position] != '\0') {
+        arithmetic_error(&state, "Invalid arithmetic expression");
+    }
+
+    if (state.error) {
+        set_exit_code(EXIT_FAILURE);
+        interpreter->expansion_failed = 1;
+        *output_length = 0;
+        return "";
+    }
+
+    char *result = arena_alloc(32);
+    *output_length = (size_t) snprintf(result, 32, "%lld", value);
+
+    return result;
+}
+
+//function which evaluates an assignment such as 'i = 1' or 'i += 1', or a conditional 'a ? b : c'
+//assignments and conditionals are right associative, so their right side is evaluated by this function again
+//returns the value of the expression
+long long evaluate_arithmetic_assignment(struct arithmetic *state) {
+    static const char *assignment_operators[] = {"=", "+=", "-=", "*=", "/=", "%=", "<<=", ">>=", "&=", "^=", "|="};
+    int start = state->position;
+    struct variable *variable = NULL;
+
+    //check for a variable name followed by an assignment operator
+    int name_length = read_arithmetic_name(state, &variable);
+    if (name_length > 0 && state->text[start] != '$') {
+        skip_arithmetic_spaces(state);
+
+        for (size_t i = 0; i < sizeof(assignment_operators) / sizeof(assignment_operators[0]); i++) {
+            size_t operator_length = strlen(assignment_operators[i]);
+
+            if (strncmp(&state->text[state->position], assignment_operators[i], operator_length) != 0 ||
+                (operator_length == 1 && state->text[state->position + 1] == '=')) {
+                continue;
+            }
+
+            state->position += (int) operator_length;
+            long long right = evaluate_arithmetic_assignment(state);
+            long long value = right;
+
+            //the operator without the '=' is applied to the old value, such as '+' for '+='
+            if (operator_length > 1) {
+                char binary_operator[3] = {0};
+                memcpy(binary_operator, assignment_operators[i], operator_length - 1);
+
+                long long left = 0;
+                if (variable != NULL && get_variable_integer(variable, &left) != 0) {
+                    arithmetic_error(state, "Variable is not a number");
+                }
+                value = apply_arithmetic_operator(state, binary_operator, left, right);
+            }
+
+            if (state->error || state->skip > 0) {
+                return value;
+            }
+
+            if (variable == NULL) {
+                variable = add_variable(&state->text[start], (size_t) name_length, 0);
+            }
+            if (set_variable_integer(variable, value) != 0) {
+                state->error = 1;
+            }
+
+            return value;
+        }
+    }
+
+    //not an assignment, so read the expression again from the start
+    state->position = start;
+    long long condition = evaluate_arithmetic_binary(state, 1);
+
+    skip_arithmetic_spaces(state);
+    if (state->text[state->position] != '?') {
+        return condition;
+    }
+    state->position++;
+
+    //only the branch which is taken can change variables
+    state->skip += !condition;
+    long long if_true = evaluate_arithmetic_assignment(state);
+    state->skip -= !condition;
+
+    skip_arithmetic_spaces(state);
+    if (state->text[state->position] != ':') {
+        arithmetic_error(state, "Missing ':' in conditional expression");
+        return 0;
+    }
+    state->position++;
+
+    state->skip += !!condition;
+    long long if_false = evaluate_arithmetic_assignment(state);
+    state->skip -= !!condition;
+
+    return condition ? if_true : if_false;
+}
+
+//function which evaluates binary operators by precedence climbing
+//operators with a precedence lower than min_precedence are left for the caller
+//returns the value of the expression
+long long evaluate_arithmetic_binary(struct arithmetic *state, int min_precedence) {
+    long long left = evaluate_arithmetic_unary(state);
+
+    while (!state->error) {
+        skip_arithmetic_spaces(state);
+
+        const struct arithmetic_operator *operator = NULL;
+        for (int i = 0; i < NUM_ARITHMETIC_OPERATORS; i++) {
+            if (strncmp(&state->text[state->position], ARITHMETIC_OPERATORS[i].text,
+                        (size_t) ARITHMETIC_OPERATORS[i].length) == 0) {
+                operator = &ARITHMETIC_OPERATORS[i];
+                break;
+            }
+        }
+
+        //an operator followed by '=' is an assignment, apart from the comparisons
+        if (operator == NULL || operator->precedence < min_precedence ||
+            (operator->precedence != 6 && operator->precedence != 7 &&
+             state->text[state->position + operator->length] == '=')) {
+            break;
+        }
+        state->position += operator->length;
+
+        //the right side of && and || is only evaluated for its value if it is needed
+        if (operator->precedence <= 2) {
+            int skip_right = operator->precedence == 1 ? left != 0 : left == 0;
+            state->skip += skip_right;
+            long long right = evaluate_arithmetic_binary(state, operator->precedence + 1);
+            state->skip -= skip_right;
+            left = operator->precedence == 1 ? (left || right) : (left && right);
+            continue;
+        }
+
+        long long right = evaluate_arithmetic_binary(state, operator->precedence + 1);
+        left = apply_arithmetic_operator(state, operator->text, left, right);
+    }
+
+    return left;
+}
+
+//function which evaluates a unary operator, a number, a variable or an expression in brackets
+//returns the value
+long long evaluate_arithmetic_unary(struct arithmetic *state) {
+    skip_arithmetic_spaces(state);
+
+    if (state->error) {
+        return 0;
+    }
+
+    const char *text = &state->text[state->position];
+
+    //'++i' and '--i' change the variable before its value is used
+    if ((text[0] == '+' && text[1] == '+') || (text[0] == '-' && text[1] == '-')) {
+        long long step = text[0] == '+' ? 1 : -1;
+        struct variable *variable = NULL;
+        long long value = 0;
+
+        state->position += 2;
+        skip_arithmetic_spaces(state);
+
+        int name_start = state->position;
+        int name_length = state->text[name_start] != '$' ? read_arithmetic_name(state, &variable) : 0;
+        if (name_length == 0) {
+            arithmetic_error(state, "Invalid arithmetic expression");
+            return 0;
+        }
+        if (variable != NULL && get_variable_integer(variable, &value) != 0) {
+            arithmetic_error(state, "Variable is not a number");
+            return 0;
+        }
+
+        value = (long long) ((unsigned long long) value + (unsigned long long) step);
+        if (state->skip == 0) {
+            if (variable == NULL) {
+                variable = add_variable(&state->text[name_start], (size_t) name_length, 0);
+            }
+            if (set_variable_integer(variable, value) != 0) {
+                state->error = 1;
+            }
+        }
+        return value;
+    }
+
+    if (text[0] == '+' || text[0] == '-' || text[0] == '!' || text[0] == '~') {
+        state->position++;
+        long long value = evaluate_arithmetic_unary(state);
+
+        switch (text[0]) {
+            case '-':
+                return (long long) (0 - (unsigned long long) value);
+            case '!':
+                return !value;
+            case '~':
+                return ~value;
+            default:
+                return value;
+        }
+    }
+
+    if (text[0] == '(') {
+        state->position++;
+        long long value = evaluate_arithmetic_assignment(state);
+
+        skip_arithmetic_spaces(state);
+        if (state->text[state->position] != ')') {
+            arithmetic_error(state, "Missing ')' in arithmetic expression");
+            return 0;
+        }
+        state->position++;
+        return value;
+    }
+
+    if (text[0] == '$' && state->interpreter->positional != NULL && is_positional_parameter(&text[1])) {
+        //the arguments of a function are used as numbers in the same way as variables, an empty one is 0
+        int name_length;
+        const char *parameter = get_positional_parameter(state->interpreter, &text[1], &name_length);
+        char *end;
+        errno = 0;
+        long long value = strtoll(parameter, &end, 0);
+        if (errno != 0 || *end != '\0') {
+            arithmetic_error(state, "Variable is not a number");
+            return 0;
+        }
+        state->position += 1 + name_length;
+        return value;
+    }
+
+    if (isdigit((unsigned char) text[0])) {
+        //numbers are written in decimal, in hexadecimal with 0x or in octal with a leading 0
+        char *end;
+        errno = 0;
+        long long value = strtoll(text, &end, 0);
+        if (errno != 0 || isalnum((unsigned char) *end) || *end == '_') {
+            arithmetic_error(state, "Invalid number");
+            return 0;
+        }
+        state->position += (int) (end - text);
+        return value;
+    }
+
+    struct variable *variable = NULL;
+    long long value = 0;
+    int name_start = state->position;
+    int name_length = read_arithmetic_name(state, &variable);
+    if (name_length == 0) {
+        arithmetic_error(state, "Invalid arithmetic expression");
+        return 0;
+    }
+    if (variable != NULL && get_variable_integer(variable, &value) != 0) {
+        arithmetic_error(state, "Variable is not a number");
+        return 0;
+    }
+
+    //'i++' and 'i--' change the variable after its value is used
+    text = &state->text[state->position];
+    if (state->text[name_start] != '$' && ((text[0] == '+' && text[1] == '+') || (text[0] == '-' && text[1] == '-'))) {
+        long long step = text[0] == '+' ? 1 : -1;
+        state->position += 2;
+
+        if (state->skip == 0) {
+            if (variable == NULL) {
+                variable = add_variable(&state->text[name_start], (size_t) name_length, 0);
+            }
+            if (set_variable_integer(variable, (long long) ((unsigned long long) value + (unsigned long long) step)) != 0) {
+                state->error = 1;
+            }
+        }
+    }
+
+    return value;
+}
+
+//function which applies a binary operator of $((...)) to two values
+//+, - and * wrap around instead of overflowing, and dividing by zero is an error
+//returns the result
+long long apply_arithmetic_operator(struct arithmetic *state, const char operator[], long long left, long long right) {
+    unsigned long long unsigned_left = (unsigned long long) left;
+    unsigned long long unsigned_right = (unsigned long long) right;
+
+    switch (operator[0]) {
+        case '+':
+            return (long long) (unsigned_left + unsigned_right);
+        case '-':
+            return (long long) (unsigned_left - unsigned_right);
+        case '*':
+            return (long long) (unsigned_left * unsigned_right);
+        case '/':
+        case '%':
+            if (right == 0) {
+                //a division in a branch which is not taken is not an error
+                if (state->skip == 0) {
+                    arithmetic_error(state, "Division by zero");
+                }
+                return 0;
+            }
+            if (right == -1) {
+                return operator[0] == '/' ? (long long) (0 - unsigned_left) : 0;
+            }
+            return operator[0] == '/' ? left / right : left % right;
+        case '<':
+            if (operator[1] == '<') {
+                return (long long) (unsigned_left << (right & 63));
+            }
+            return operator[1] == '=' ? left <= right : left < right;
+        case '>':
+            if (operator[1] == '>') {
+                return left >> (right & 63);
+            }
+            return operator[1] == '=' ? left >= right : left > right;
+        case '=':
+            return left == right;
+        case '!':
+            return left != right;
+        case '&':
+            return left & right;
+        case '^':
+            return left ^ right;
+        case '|':
+            return left | right;
+        default:
+            return 0;
+    }
+}
+
+//function which reads a variable name in a $((...)) expression, written as NAME, $NAME or ${NAME}
+//variable is set to the variable, or NULL if it is not set
+//returns the length of the name, or 0 if there is no name
+int read_arithmetic_name(struct arithmetic *state, struct variable **variable) {
+    const char *text = &state->text[state->position];
+    int dollar = text[0] == '$';
+    int braces = dollar && text[1] == '{';
+    int name_start = dollar + braces;
+    int name_end = name_start;
+
+    *variable = NULL;
+
+    if (!isalpha((unsigned char) text[name_start]) && text[name_start] != '_') {
+        return 0;
+    }
+    while (isalnum((unsigned char) text[name_end]) || text[name_end] == '_') {
+        name_end++;
+    }
+    if (braces && text[name_end] != '}') {
+        return 0;
+    }
+
+    *variable = find_variable(&text[name_start], (size_t) (name_end - name_start));
+    state->position += name_end + braces;
+
+    return name_end - name_start;
+}
+
+//function which skips the spaces, tabs and new lines in a $((...)) expression
+void skip_arithmetic_spaces(struct arithmetic *state) {
+    while (state->text[state->position] == ' ' || state->text[state->position] == '\t' ||
+           state->text[state->position] == '\n') {
+        state->position++;
+    }
+}
+
+//function which prints an error in a $((...)) expression, only the first error is printed
+void arithmetic_error(struct arithmetic *state, const char message[]) {
+    if (!state->error) {
+        printf("%s: %s\n", message, state->text);
+    }
+    state->error = 1;
+}
+
+//function which expands the tokens of a command into the arguments of the interpreter, allocated from the line arena
+//brace expansions and globs can make many arguments out of one word, so the arguments are grown when needed
+//the arguments and the environment together have to fit in ARG_MAX, the limit of the arguments of a program
+//returns the number of arguments, or -1 if there are too many or a $((...)) could not be evaluated
+int expand_tokens(struct interpreter *interpreter, const struct token tokens[], int token_count) {
+    static long argument_limit = 0;
+    size_t capacity = (size_t) token_count + 1;
+    size_t size = 0;
+    int count = 0;
+    struct word_source source;
+    char *word;
+
+    if (argument_limit == 0) {
+        argument_limit = sysconf(_SC_ARG_MAX) > 0 ? sysconf(_SC_ARG_MAX) : 128 * 1024;
+    }
+
+    interpreter->args = arena_alloc(capacity * sizeof(char *));
+    interpreter->expansion_failed = 0;
+    start_word_source(interpreter, &source, tokens, token_count);
+
+    while ((word = next_word(&source)) != NULL) {
+        if (source.temporary) {
+            word = arena_strndup(word, strlen(word));
+        }
+
+        //the environment is only counted once the arguments are large
+        size += strlen(word) + 1 + sizeof(char *);
+        if (size > 64 * 1024 && size + get_environment_size() > (size_t) argument_limit) {
+            printf("Argument list too long.\n");
+            clear_and_null_args(interpreter);
+            return -1;
+        }
+
+        if ((size_t) count + 1 == capacity) {
+            interpreter->args = arena_grow(interpreter->args, capacity * sizeof(char *), capacity * 2 * sizeof(char *));
+            capacity *= 2;
+        }
+        interpreter->args[count++] = word;
+    }
+
+    //the error has been printed, and the command is not run so that it does not change EXITCODE
+    if (interpreter->expansion_failed) {
+        interpreter->expansion_failed = 0;
+        clear_and_null_args(interpreter);
+        return -1;
+    }
+
+    interpreter->args[count] = NULL;
+    interpreter->arg_count = count;
+
+    return count;
+}
+
+//function which starts producing the words of a list of tokens with next_word
+void start_word_source(struct interpreter *interpreter, struct word_source *source, const struct token tokens[],
+                       int token_count) {
+    memset(source, 0, sizeof(struct word_source));
+    source->interpreter = interpreter;
+    source->tokens = tokens;
+    source->token_count = token_count;
+}
+
+//function which produces the next expanded word of a word source
+//a word with a brace expansion gives one word at a time, and every word which is a glob gives its matches
+//if temporary is set in the source, the word is only valid until the next call
+//returns the word, or NULL once every token has been expanded
+char *next_word(struct word_source *source) {
+    source->temporary = 0;
+
+    while (1) {
+        if (source->match_position < source->match_count) {
+            return source->matches[source->match_position++];
+        }
+
+        if (source->braces != NULL && !source->braces_finished) {
+            //make the text of the current word, then move the braces on to the next one
+            size_t length = write_brace_word(source->braces, source, 0);
+            source->buffer[length] = '\0';
+            source->braces_finished = !advance_brace_expansion(source->braces);
+
+            struct token word = {TOKEN_WORD, source->buffer, (int) length, source->brace_flags};
+            if (word.flags & WORD_GLOB) {
+                char *match = next_glob_match(source, &word);
+                if (match != NULL) {
+                    return match;
+                }
+                continue;
+            }
+
+            if (word.flags == 0) {
+                source->temporary = 1;
+                return source->buffer;
+            }
+            return expand_word(source->interpreter, &word);
+        }
+        source->braces = NULL;
+
+        if (source->position == source->token_count) {
+            return NULL;
+        }
+
+        const struct token *token = &source->tokens[source->position++];
+
+        //operators point to constant strings, they are not changed so they are used as they are
+        if (token->type != TOKEN_WORD) {
+            return token->text;
+        }
+
+        if ((token->flags & WORD_BRACE) && (source->braces = parse_brace_expansion(token->text, token->length)) != NULL) {
+            reset_brace_expansion(source->braces);
+            source->braces_finished = 0;
+            source->brace_flags = token->flags & ~WORD_BRACE;
+            continue;
+        }
+
+        if (token->flags & WORD_GLOB) {
+            char *match = next_glob_match(source, token);
+            if (match != NULL) {
+                return match;
+            }
+            continue;
+        }
+
+        return expand_word(source->interpreter, token);
+    }
+}
+
+//function which expands a word which is a glob, the matches are kept in the source to be produced by next_word
+//a pattern which matches no files is kept as it was entered, without the quotes
+//returns the first match, or the word itself if nothing matched
+char *next_glob_match(struct word_source *source, const struct token *token) {
+    char *pattern = expand_word_text(source->interpreter, token, 1);
+
+    source->matches = expand_glob(pattern, &source->match_count);
+    source->match_position = 0;
+
+    if (source->match_count == 0) {
+        return unescape_glob_pattern(pattern, strlen(pattern));
+    }
+
+    source->match_position = 1;
+    return source->matches[0];
+}
+
+//function which returns the number of bytes the environment takes up when a program is started
+size_t get_environment_size() {
+    size_t size = sizeof(char *);
+
+    for (size_t i = 0; i < ENVP_COUNT; i++) {
+        size += strlen(ENVP[i]) + 1 + sizeof(char *);
+    }
+
+    return size;
+}
+
+//function which parses the brace expansions of a word, such as 'file{1..3}.{log,txt}'
+//braces in quotes, ${NAME} and braces which are neither a list nor a range are kept as they are
+//returns the parts of the word, or NULL if the word has no brace expansion
+struct brace_expansion *parse_brace_expansion(const char text[], int length) {
+    struct brace_expansion *expansion = arena_alloc(sizeof(struct brace_expansion));
+    int part_capacity = 4;
+    int text_start = 0;
+    int found = 0;
+
+    expansion->parts = arena_alloc((size_t) part_capacity * sizeof(struct brace_part));
+    expansion->part_count = 0;
+
+    for (int i = 0; i <= length; i++) {
+        int end = -1;
+        struct brace_part part;
+        memset(&part, 0, sizeof(struct brace_part));
+
+        if (i < length) {
+            if (text[i] == '\\') {
+                i++;
+                continue;
+            } else if (text[i] == '\'' || text[i] == '"') {
+                //skip to the closing quote, in double quotes a backslash escapes the next character
+                char quote = text[i];
+                for (i++; i < length && text[i] != quote; i++) {
+                    i += quote == '"' && text[i] == '\\';
+                }
+                continue;
+            } else if (text[i] == '$' && i + 1 < length && text[i + 1] == '{') {
+                int close = find_brace_end(text, i + 1, length);
+                i = close > 0 ? close : i + 1;
+                continue;
+            } else if (text[i] != '{' || (end = find_brace_end(text, i, length)) < 0) {
+                continue;
+            }
+
+            //split the inside of the braces at the commas which are not in quotes or inner braces
+            int alternative_start = i + 1;
+            int alternative_capacity = 4;
+            part.alternatives = arena_alloc((size_t) alternative_capacity * sizeof(struct brace_expansion *));
+
+            for (int j = i + 1; j <= end; j++) {
+                if (text[j] == '\\') {
+                    j++;
+                } else if (text[j] == '\'' || text[j] == '"') {
+                    char quote = text[j];
+                    for (j++; j < end && text[j] != quote; j++) {
+                        j += quote == '"' && text[j] == '\\';
+                    }
+                } else if (text[j] == '{') {
+                    j = find_brace_end(text, j, end);
+                    if (j < 0) {
+                        j = end - 1;
+                    }
+                } else if (text[j] == ',' || (j == end && part.alternative_count > 0)) {
+                    struct brace_expansion *alternative = parse_brace_expansion(&text[alternative_start], j - alternative_start);
+                    if (alternative == NULL) {
+                        //an alternative without braces is one text part
+                        alternative = arena_alloc(sizeof(struct brace_expansion));
+                        alternative->parts = arena_alloc(sizeof(struct brace_part));
+                        memset(alternative->parts, 0, sizeof(struct brace_part));
+                        alternative->parts[0].type = BRACE_TEXT;
+                        alternative->parts[0].text = &text[alternative_start];
+                        alternative->parts[0].length = j - alternative_start;
+                        alternative->part_count = 1;
+                    }
+
+                    if (part.alternative_count == alternative_capacity) {
+                        part.alternatives = arena_grow(part.alternatives,
+                                                       (size_t) alternative_capacity * sizeof(struct brace_expansion *),
+                                                       (size_t) alternative_capacity * 2 * sizeof(struct brace_expansion *));
+                        alternative_capacity *= 2;
+                    }
+                    part.alternatives[part.alternative_count++] = alternative;
+                    alternative_start = j + 1;
+                }
+            }
+
+            if (part.alternative_count > 0) {
+                part.type = BRACE_LIST;
+            } else if (parse_brace_range(&text[i + 1], end - i - 1, &part)) {
+                part.type = BRACE_RANGE;
+            } else {
+                //braces such as {} or {a} are kept as text, but braces inside them can still be expanded
+                continue;
+            }
+        }
+
+        //the text before the braces, and at the end of the word, is a part of its own
+        if (expansion->part_count + 2 > part_capacity) {
+            expansion->parts = arena_grow(expansion->parts, (size_t) part_capacity * sizeof(struct brace_part),
+                                          (size_t) part_capacity * 2 * sizeof(struct brace_part));
+            part_capacity *= 2;
+        }
+        if (i > text_start) {
+            struct brace_part *text_part = &expansion->parts[expansion->part_count++];
+            memset(text_part, 0, sizeof(struct brace_part));
+            text_part->type = BRACE_TEXT;
+            text_part->text = &text[text_start];
+            text_part->length = i - text_start;
+        }
+        if (i < length) {
+            expansion->parts[expansion->part_count++] = part;
+            found = 1;
+            i = end;
+            text_start = end + 1;
+        }
+    }
+
+    return found ? expansion : NULL;
+}
+
+//function which finds the '}' which closes a '{', skipping quotes and nested braces
+//returns the position of the '}', or -1 if the brace is not closed before length
+int find_brace_end(const char text[], int start, int length) {
+    int depth = 0;
+
+    for (int i = start; i < length; i++) {
+        if (text[i] == '\\') {
+            i++;
+        } else if (text[i] == '\'' || text[i] == '"') {
+            char quote = text[i];
+            for (i++; i < length && text[i] != quote; i++) {
+                i += quote == '"' && text[i] == '\\';
+            }
+        } else if (text[i] == '{') {
+            depth++;
+        } else if (text[i] == '}' && --depth == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+//function which parses the inside of the braces of a range such as 1..9, -5..5..2, 01..10 or a..z
+//returns 1 if the text is a range, returns 0 otherwise
+int parse_brace_range(const char text[], int length, struct brace_part *part) {
+    char *range = arena_strndup(text, (size_t) length);
+    char *first_end = strstr(range, "..");
+
+    if (first_end == NULL) {
+        return 0;
+    }
+    *first_end = '\0';
+
+    char *second = first_end + 2;
+    char *second_end = strstr(second, "..");
+    long long step = 1;
+    char *end;
+
+    if (second_end != NULL) {
+        *second_end = '\0';
+        errno = 0;
+        step = strtoll(second_end + 2, &end, 10);
+        if (errno != 0 || *end != '\0' || second_end[2] == '\0') {
+            return 0;
+        }
+    }
+
+    //bash ignores the sign of the step, the direction comes from the two ends
+    step = step < 0 ? -step : step;
+    if (step == 0) {
+        step = 1;
+    }
+
+    if (isalpha((unsigned char) range[0]) && range[1] == '\0' && isalpha((unsigned char) second[0]) && second[1] == '\0') {
+        part->letters = 1;
+        part->start = (unsigned char) range[0];
+        part->end = (unsigned char) second[0];
+    } else {
+        errno = 0;
+        part->start = strtoll(range, &end, 10);
+        if (errno != 0 || *end != '\0' || range[0] == '\0') {
+            return 0;
+        }
+        part->end = strtoll(second, &end, 10);
+        if (errno != 0 || *end != '\0' || second[0] == '\0') {
+            return 0;
+        }
+
+        //a leading zero in either end pads every number to the width of the longer end
+        int first_padded = range[range[0] == '-'] == '0' && range[(range[0] == '-') + 1] != '\0';
+        int second_padded = second[second[0] == '-'] == '0' && second[(second[0] == '-') + 1] != '\0';
+        if (first_padded || second_padded) {
+            part->width = (int) (strlen(range) > strlen(second) ? strlen(range) : strlen(second));
+        }
+    }
+
+    part->step = part->start <= part->end ? step : -step;
+
+    return 1;
+}
+
+//function which moves every part of a brace expansion to its first choice
+void reset_brace_expansion(struct brace_expansion *expansion) {
+    for (int i = 0; i < expansion->part_count; i++) {
+        struct brace_part *part = &expansion->parts[i];
+
+        if (part->type == BRACE_RANGE) {
+            part->current = part->start;
+        } else if (part->type == BRACE_LIST) {
+            part->alternative = 0;
+            for (int j = 0; j < part->alternative_count; j++) {
+                reset_brace_expansion(part->alternatives[j]);
+            }
+        }
+    }
+}
+
+//function which moves a brace expansion on to its next word, the last part changes first like the digits of a counter
+//returns 1 if there is a next word, returns 0 if every word has been produced and the expansion is back at the first one
+int advance_brace_expansion(struct brace_expansion *expansion) {
+    for (int i = expansion->part_count - 1; i >= 0; i--) {
+        struct brace_part *part = &expansion->parts[i];
+
+        if (part->type == BRACE_RANGE) {
+            //the range stops at its end even if the step goes past it, without overflowing
+            unsigned long long left = part->step > 0 ? (unsigned long long) part->end - (unsigned long long) part->current
+                                                     : (unsigned long long) part->current - (unsigned long long) part->end;
+            unsigned long long step = part->step > 0 ? (unsigned long long) part->step : 0 - (unsigned long long) part->step;
+            if (step <= left) {
+                part->current += part->step;
+                return 1;
+            }
+            part->current = part->start;
+        } else if (part->type == BRACE_LIST) {
+            if (advance_brace_expansion(part->alternatives[part->alternative])) {
+                return 1;
+            }
+            if (++part->alternative < part->alternative_count) {
+                return 1;
+            }
+            part->alternative = 0;
+        }
+    }
+
+    return 0;
+}
+
+//function which writes the current word of a brace expansion into the buffer of the word source, after length bytes
+//returns the length of the text in the buffer
+size_t write_brace_word(const struct brace_expansion *expansion, struct word_source *source, size_t length) {
+    for (int i = 0; i < expansion->part_count; i++) {
+        const struct brace_part *part = &expansion->parts[i];
+
+        if (part->type == BRACE_LIST) {
+            length = write_brace_word(part->alternatives[part->alternative], source, length);
+            continue;
+        }
+
+        //a number takes at most 20 characters plus the padding
+        size_t needed = length + (part->type == BRACE_TEXT ? (size_t) part->length : (size_t) part->width + 24) + 1;
+        if (needed > source->buffer_capacity) {
+            size_t capacity = source->buffer_capacity * 2 > needed ? source->buffer_capacity * 2 : needed;
+            source->buffer = arena_grow(source->buffer, source->buffer_capacity, capacity);
+            source->buffer_capacity = capacity;
+        }
+
+        if (part->type == BRACE_TEXT) {
+            memcpy(&source->buffer[length], part->text, (size_t) part->length);
+            length += (size_t) part->length;
+        } else if (part->letters) {
+            source->buffer[length++] = (char) part->current;
+        } else {
+            length += (size_t) sprintf(&source->buffer[length], "%0*lld", part->width, part->current);
+        }
+    }
+
+    return length;
+}
+
+//function which finds every path matching a glob pattern, such as 'logs/*.log' or '*/[a-c]?'
+//the pattern is matched one path component at a time, and only the components with wildcards read a directory
+//names starting with '.' are only matched by a component which starts with '.'
+//returns the sorted paths allocated from the line arena, match_count is 0 if nothing matched
+char **expand_glob(const char pattern[], int *match_count) {
+    int path_count = 1;
+    size_t path_capacity = 16;
+    char **paths = arena_alloc(path_capacity * sizeof(char *));
+    const char *component = pattern;
+    int wildcards = 0;
+
+    //the paths start at the root for an absolute pattern, otherwise in the current directory
+    paths[0] = pattern[0] == '/' ? "/" : "";
+    while (*component == '/') {
+        component++;
+    }
+
+    while (*component != '\0' && path_count > 0) {
+        const char *end = component;
+        while (*end != '\0' && *end != '/') {
+            end += *end == '\\' && end[1] != '\0' ? 2 : 1;
+        }
+        int last = *end == '\0';
+
+        struct glob_pattern compiled;
+        compile_glob_pattern(component, (size_t) (end - component), &compiled);
+        wildcards |= compiled.wildcards;
+
+        int new_count = 0;
+        size_t new_capacity = 16;
+        char **new_paths = arena_alloc(new_capacity * sizeof(char *));
+
+        for (int i = 0; i < path_count; i++) {
+            size_t path_length = strlen(paths[i]);
+            struct glob_directory *directory = NULL;
+            int name_count = 1;
+
+            if (compiled.wildcards) {
+                directory = read_glob_directory(path_length > 0 ? paths[i] : ".");
+                name_count = directory != NULL ? directory->count : 0;
+            }
+
+            for (int j = 0; j < name_count; j++) {
+                const char *name;
+                size_t name_length;
+
+                if (compiled.wildcards) {
+                    name = directory->names[j];
+                    if ((name[0] == '.' && !compiled.matches_dot) || !match_glob_pattern(&compiled, name)) {
+                        continue;
+                    }
+                    name_length = strlen(name);
+                } else {
+                    name = unescape_glob_pattern(component, (size_t) (end - component));
+                    name_length = strlen(name);
+                }
+
+                //the path is the directory followed by the name, with a '/' after it unless it is the last component
+                //a name in the current directory is already a path, so it is not copied
+                char *path = (char *) name;
+                if (path_length > 0 || !last) {
+                    path = arena_alloc(path_length + name_length + 2);
+                    memcpy(path, paths[i], path_length);
+                    memcpy(&path[path_length], name, name_length);
+                    path[path_length + name_length] = last ? '\0' : '/';
+                    path[path_length + name_length + 1] = '\0';
+                }
+
+                //names which are not the last component have to be directories, and plain names have to exist
+                if (!last || !compiled.wildcards) {
+                    unsigned char type = compiled.wildcards ? directory->types[j] : DT_UNKNOWN;
+                    struct stat file_status;
+
+                    if (type == DT_UNKNOWN || type == DT_LNK) {
+                        if ((last ? lstat(path, &file_status) : stat(path, &file_status)) != 0) {
+                            continue;
+                        }
+                        type = S_ISDIR(file_status.st_mode) ? DT_DIR : DT_REG;
+                    }
+                    if (!last && type != DT_DIR) {
+                        continue;
+                    }
+                }
+
+                if (new_count == (int) new_capacity) {
+                    new_paths = arena_grow(new_paths, new_capacity * sizeof(char *), new_capacity * 2 * sizeof(char *));
+                    new_capacity *= 2;
+                }
+                new_paths[new_count++] = path;
+            }
+        }
+
+        paths = new_paths;
+        path_count = new_count;
+
+        //repeated slashes between components are skipped, a slash at the end is kept in the paths
+        component = end;
+        while (*component == '/') {
+            component++;
+        }
+    }
+
+    //a pattern without any wildcards, such as one which only had them in quotes, is not expanded
+    if (!wildcards) {
+        path_count = 0;
+    }
+
+    sort_paths(paths, path_count);
+    *match_count = path_count;
+
+    return paths;
+}
+
+//function which reads the names in a directory with large getdents64 calls
+//the names are kept in GLOB_CACHE, so a directory is only read once for the words of a command
+//returns the names, or NULL if the directory cannot be read
+struct glob_directory *read_glob_directory(const char path[]) {
+    static char *buffer = NULL;
+
+    for (struct glob_directory *directory = GLOB_CACHE; directory != NULL; directory = directory->next) {
+        if (strcmp(directory->path, path) == 0) {
+            return directory;
+        }
+    }
+
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if (buffer == NULL && (buffer = malloc(GLOB_BUFFER_SIZE)) == NULL) {
+        perror("Unable to allocate memory");
+        exit(EXIT_FAILURE);
+    }
+
+    struct glob_directory *directory = arena_alloc(sizeof(struct glob_directory));
+    size_t capacity = 64;
+    directory->path = arena_strndup(path, strlen(path));
+    directory->names = arena_alloc(capacity * sizeof(char *));
+    directory->types = arena_alloc(capacity);
+    directory->count = 0;
+
+    long bytes_read;
+    while ((bytes_read = syscall(SYS_getdents64, fd, buffer, GLOB_BUFFER_SIZE)) > 0) {
+        //the batch is copied to the line arena in one go instead of copying every name
+        char *batch = arena_alloc((size_t) bytes_read);
+        memcpy(batch, buffer, (size_t) bytes_read);
+
+        for (long position = 0; position < bytes_read;) {
+            struct directory_entry64 *entry = (struct directory_entry64 *) &buffer[position];
+            position += entry->record_length;
+
+            if (strcmp(entry->name, ".") == 0 || strcmp(entry->name, "..") == 0) {
+                continue;
+            }
+
+            if (directory->count == (int) capacity) {
+                directory->names = arena_grow(directory->names, capacity * sizeof(char *), capacity * 2 * sizeof(char *));
+                directory->types = arena_grow(directory->types, capacity, capacity * 2);
+                capacity *= 2;
+            }
+
+            //the names point into the copy of the whole batch
+            directory->names[directory->count] = &batch[(char *) entry->name - buffer];
+            directory->types[directory->count] = entry->type;
+            directory->count++;
+        }
+    }
+
+    close(fd);
+
+    directory->next = GLOB_CACHE;
+    GLOB_CACHE = directory;
+
+    return directory;
+}
+
+//function which compiles one path component of a glob pattern into a list of elements
+//a backslash makes the next character literal, and a '[' without a closing ']' is literal
+void compile_glob_pattern(const char component[], size_t length, struct glob_pattern *pattern) {
+    static const struct {
+        const char *name;
+        int (*function)(int);
+    } classes[] = {{"alpha", isalpha}, {"digit", isdigit}, {"alnum", isalnum}, {"upper", isupper},
+                   {"lower", islower}, {"space", isspace}, {"punct", ispunct}, {"xdigit", isxdigit}};
+
+    pattern->elements = arena_alloc(length * sizeof(struct glob_element) + 1);
+    pattern->element_count = 0;
+    pattern->wildcards = 0;
+    pattern->matches_dot = length > 0 && component[0] == '.';
+
+    for (size_t i = 0; i < length; i++) {
+        struct glob_element *element = &pattern->elements[pattern->element_count++];
+        element->type = GLOB_LITERAL;
+        element->character = (unsigned char) component[i];
+        element->set = NULL;
+
+        if (component[i] == '\\' && i + 1 < length) {
+            element->character = (unsigned char) component[++i];
+        } else if (component[i] == '?') {
+            element->type = GLOB_ANY_CHARACTER;
+            pattern->wildcards = 1;
+        } else if (component[i] == '*') {
+            //several stars in a row are the same as one
+            if (pattern->element_count > 1 && element[-1].type == GLOB_ANY_STRING) {
+                pattern->element_count--;
+            }
+            element->type = GLOB_ANY_STRING;
+            pattern->wildcards = 1;
+        } else if (component[i] == '[') {
+            //a ']' straight after '[' or '[!' is part of the set
+            size_t j = i + 1;
+            int negated = j < length && (component[j] == '!' || component[j] == '^');
+            j += negated;
+            size_t first = j;
+            while (j < length && (component[j] != ']' || j == first)) {
+                const char *class_end = NULL;
+                if (component[j] == '[' && j + 1 < length && component[j + 1] == ':') {
+                    class_end = strstr(&component[j + 2], ":]");
+                }
+
+                if (class_end != NULL && class_end < &component[length]) {
+                    j = (size_t) (class_end - component) + 2;
+                } else {
+                    j += component[j] == '\\' && j + 1 < length ? 2 : 1;
+                }
+            }
+            if (j >= length) {
+                continue;
+            }
+
+            element->type = GLOB_CLASS;
+            element->set = arena_alloc(32);
+            memset(element->set, 0, 32);
+            pattern->wildcards = 1;
+
+            for (size_t k = first; k < j; k++) {
+                unsigned char low = (unsigned char) component[k];
+
+                //named classes such as [:digit:]
+                if (low == '[' && k + 1 < j && component[k + 1] == ':') {
+                    const char *class_end = strstr(&component[k + 2], ":]");
+                    for (size_t c = 0; class_end != NULL && class_end < &component[j] && c < sizeof(classes) / sizeof(classes[0]); c++) {
+                        if (strncmp(&component[k + 2], classes[c].name, strlen(classes[c].name)) == 0 &&
+                            &component[k + 2 + strlen(classes[c].name)] == class_end) {
+                            for (int character = 1; character < 256; character++) {
+                                if (classes[c].function(character)) {
+                                    element->set[character / 8] |= (unsigned char) (1 << (character % 8));
+                                }
+                            }
+                        }
+                    }
+                    if (class_end != NULL && class_end < &component[j]) {
+                        k = (size_t) (class_end - component) + 1;
+                        continue;
+                    }
+                }
+
+                if (low == '\\' && k + 1 < j) {
+                    low = (unsigned char) component[++k];
+                }
+                unsigned char high = low;
+
+                //a range such as a-z, a '-' at the end of the set is literal
+                if (k + 2 < j && component[k + 1] == '-') {
+                    k += 2;
+                    if (component[k] == '\\' && k + 1 < j) {
+                        k++;
+                    }
+                    high = (unsigned char) component[k];
+                }
+
+                for (int character = low; character <= high; character++) {
+                    element->set[character / 8] |= (unsigned char) (1 << (character % 8));
+                }
+            }
+
+            if (negated) {
+                for (int byte = 0; byte < 32; byte++) {
+                    element->set[byte] = (unsigned char) ~element->set[byte];
+                }
+            }
+            i = j;
+        }
+    }
+
+    //the literal characters at the start, and at the end after the last '*', are checked before matching
+    int prefix_end = 0;
+    while (prefix_end < pattern->element_count && pattern->elements[prefix_end].type == GLOB_LITERAL) {
+        prefix_end++;
+    }
+    int suffix_start = pattern->element_count;
+    while (suffix_start > prefix_end && pattern->elements[suffix_start - 1].type == GLOB_LITERAL) {
+        suffix_start--;
+    }
+    if (suffix_start == prefix_end || pattern->elements[suffix_start - 1].type != GLOB_ANY_STRING) {
+        suffix_start = pattern->element_count;
+    }
+
+    char *prefix = arena_alloc((size_t) prefix_end + 1);
+    for (int i = 0; i < prefix_end; i++) {
+        prefix[i] = (char) pattern->elements[i].character;
+    }
+    pattern->prefix = prefix;
+    pattern->prefix_length = (size_t) prefix_end;
+
+    char *suffix = arena_alloc((size_t) (pattern->element_count - suffix_start) + 1);
+    for (int i = suffix_start; i < pattern->element_count; i++) {
+        suffix[i - suffix_start] = (char) pattern->elements[i].character;
+    }
+    pattern->suffix = suffix;
+    pattern->suffix_length = (size_t) (pattern->element_count - suffix_start);
+}
+
+//function which matches a name against a compiled glob pattern
+//a '*' remembers where it was, so that a failed match only goes back to the last '*' instead of trying every split
+//returns 1 if the name matches, returns 0 otherwise
+int match_glob_pattern(const struct glob_pattern *pattern, const char name[]) {
+    size_t name_length = strlen(name);
+
+    if (name_length < pattern->prefix_length + pattern->suffix_length ||
+        memcmp(name, pattern->prefix, pattern->prefix_length) != 0 ||
+        memcmp(&name[name_length - pattern->suffix_length], pattern->suffix, pattern->suffix_length) != 0) {
+        return 0;
+    }
+
+    int element = 0;
+    size_t position = 0;
+    int star_element = -1;
+    size_t star_position = 0;
+
+    while (position < name_length) {
+        if (element < pattern->element_count && pattern->elements[element].type == GLOB_ANY_STRING) {
+            star_element = ++element;
+            star_position = position;
+        } else if (element < pattern->element_count &&
+                   glob_element_matches(&pattern->elements[element], (unsigned char) name[position])) {
+            element++;
+            position++;
+        } else if (star_element >= 0) {
+            //let the last '*' take one more character and try again from there
+            element = star_element;
+            position = ++star_position;
+        } else {
+            return 0;
+        }
+    }
+
+    while (element < pattern->element_count && pattern->elements[element].type == GLOB_ANY_STRING) {
+        element++;
+    }
+
+    return element == pattern->element_count;
+}
+
+//function which checks if one character matches one element of a glob pattern
+//returns 1 if it matches, returns 0 otherwise
+int glob_element_matches(const struct glob_element *element, unsigned char character) {
+    switch (element->type) {
+        case GLOB_LITERAL:
+            return element->character == character;
+        case GLOB_ANY_CHARACTER:
+            return 1;
+        case GLOB_CLASS:
+            return (element->set[character / 8] >> (character % 8)) & 1;
+        default:
+            return 0;
+    }
+}
+
+//function which removes the backslashes added to a glob pattern by expand_word_text
+//returns the text allocated from the line arena
+char *unescape_glob_pattern(const char pattern[], size_t length) {
+    char *text = arena_alloc(length + 1);
+    size_t text_length = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        if (pattern[i] == '\\' && i + 1 < length) {
+            i++;
+        }
+        text[text_length++] = pattern[i];
+    }
+    text[text_length] = '\0';
+
+    return text;
+}
+
+//function which sorts paths in the same order as strcmp
+//the paths of a pattern usually share a prefix such as 'server-', so they are sorted by the bytes after it
+void sort_paths(char *paths[], int count) {
+    if (count < 2) {
+        return;
+    }
+
+    size_t common = strlen(paths[0]);
+    for (int i = 1; i < count && common > 0; i++) {
+        size_t length = 0;
+        while (length < common && paths[i][length] == paths[0][length]) {
+            length++;
+        }
+        common = length;
+    }
+
+    struct sort_key *keys = arena_alloc((size_t) count * sizeof(struct sort_key));
+    for (int i = 0; i < count; i++) {
+        const unsigned char *text = (const unsigned char *) &paths[i][common];
+        unsigned long long key = 0;
+        int ended = 0;
+
+        //the bytes after the end of the path are 0, which sorts a shorter path first as strcmp does
+        for (int byte = 0; byte < 8; byte++) {
+            unsigned char character = ended ? 0 : text[byte];
+            ended = character == '\0';
+            key = key << 8 | character;
+        }
+
+        keys[i].key = key;
+        keys[i].text = paths[i];
+    }
+
+    //radix sort on the keys one byte at a time from the lowest byte, skipping bytes which are the same in every key
+    struct sort_key *sorted = arena_alloc((size_t) count * sizeof(struct sort_key));
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t positions[257] = {0};
+
+        for (int i = 0; i < count; i++) {
+            positions[((keys[i].key >> shift) & 0xff) + 1]++;
+        }
+        if (positions[((keys[0].key >> shift) & 0xff) + 1] == (size_t) count) {
+            continue;
+        }
+
+        for (int byte = 1; byte < 257; byte++) {
+            positions[byte] += positions[byte - 1];
+        }
+        for (int i = 0; i < count; i++) {
+            sorted[positions[(keys[i].key >> shift) & 0xff]++] = keys[i];
+        }
+
+        struct sort_key *swap = keys;
+        keys = sorted;
+        sorted = swap;
+    }
+
+    //paths with the same key are next to each other, and they are sorted by the rest of the path
+    for (int start = 0; start < count;) {
+        int end = start + 1;
+        while (end < count && keys[end].key == keys[start].key) {
+            end++;
+        }
+        if (end - start > 1) {
+            qsort(&keys[start], (size_t) (end - start), sizeof(struct sort_key), compare_sort_keys);
+        }
+        start = end;
+    }
+
+    for (int i = 0; i < count; i++) {
+        paths[i] = keys[i].text;
+    }
+}
+
+//function which compares two paths with the same sort key for qsort
+int compare_sort_keys(const void *first, const void *second) {
+    const struct sort_key *first_key = first;
+    const struct sort_key *second_key = second;
+
+    return strcmp(first_key->text, second_key->text);
+}
+
+//function which allocates memory from the line arena, which is released when the line has been run
+//a new block is added to the chain when the current one is full
+//returns the memory, the shell exits if no memory is left
+void *arena_alloc(size_t size) {
+    struct arena_block *block = LINE_ARENA.current;
+
+    size = (size + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+
+    //move to the next block in the chain, or add a new block, if the current one is full
+    while (block == NULL || block->used + size > block->size) {
+        struct arena_block *next = block == NULL ? LINE_ARENA.first : block->next;
+
+        if (next == NULL || next->size < size) {
+            size_t block_size = size > LINE_ARENA.block_size ? size : LINE_ARENA.block_size;
+            struct arena_block *new_block = malloc(sizeof(struct arena_block) + block_size);
+            if (new_block == NULL) {
+                perror("Unable to allocate memory");
+                exit(EXIT_FAILURE);
+            }
+
+            new_block->size = block_size;
+            new_block->next = next;
+            if (block == NULL) {
+                LINE_ARENA.first = new_block;
+            } else {
+                block->next = new_block;
+            }
+            next = new_block;
+        }
+
+        block = next;
+        block->used = 0;
+    }
+
+    void *memory = &block->data[block->used];
+    block->used += size;
+
+    LINE_ARENA.current = block;
+    LINE_ARENA.last = memory;
+
+    return memory;
+}
+
+//function which grows memory from the line arena, the last allocation is grown in place if it fits
+//returns the grown memory, which keeps the contents of the old memory
+void *arena_grow(void *pointer, size_t old_size, size_t new_size) {
+    struct arena_block *block = LINE_ARENA.current;
+
+    if (pointer != NULL && pointer == LINE_ARENA.last) {
+        size_t start = (size_t) ((char *) pointer - block->data);
+        size_t aligned_size = (new_size + ARENA_ALIGNMENT - 1) & ~((size_t) ARENA_ALIGNMENT - 1);
+
+        if (start + aligned_size <= block->size) {
+            block->used = start + aligned_size;
+            return pointer;
+        }
+    }
+
+    void *memory = arena_alloc(new_size);
+    if (pointer != NULL) {
+        memcpy(memory, pointer, old_size);
+    }
+
+    return memory;
+}
+
+//function which copies the first length characters of a string into the line arena
+char *arena_strndup(const char input[], size_t length) {
+    char *copy = arena_alloc(length + 1);
+
+    memcpy(copy, input, length);
+    copy[length] = '\0';
+
+    return copy;
+}
+
+//function which returns the current position of the line arena
+struct arena_mark arena_get_mark() {
+    struct arena_mark mark = {LINE_ARENA.current, LINE_ARENA.current != NULL ? LINE_ARENA.current->used : 0};
+
+    return mark;
+}
+
+//function which releases everything allocated from the line arena after the mark was taken
+//the blocks are kept so that the next lines do not have to allocate them again
+void arena_release(struct arena_mark mark) {
+    LINE_ARENA.current = mark.block;
+    if (mark.block != NULL) {
+        mark.block->used = mark.used;
+    }
+    LINE_ARENA.last = NULL;
+}
+
+//function which frees every block of an arena which is not the line arena, such as the arena of a function
+void free_arena(struct arena *arena) {
+    struct arena_block *block = arena->first;
+
+    while (block != NULL) {
+        struct arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->last = NULL;
+}
+
+//function which clears all the input arguments and sets the pointers to null
+//the arguments are allocated from the line arena, so they are released with the line and not cleared here
+void clear_and_null_args(struct interpreter *interpreter) {
+    interpreter->args = NO_ARGS;
+    interpreter->arg_count = 0;
+}
+
+//function which checks whether the first argument in the input is an internal command
+//returns -1 if the command is not found, returns a value greater or equal to 0 if it is found
+int check_internal_command(const char input[]) {
+    int command_position = -1;
+
+    for (int i = 0; i < NUM_INTERNAL_COMMANDS; i++) {
+        if (strcasecmp(input, INTERNAL_COMMANDS[i]) == 0) {
+            command_position = i;
+            break;
+        }
+    }
+
+    return command_position;
+}
+
+//function which runs the expanded input as a function, an internal command or an external command
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int execute_command(struct interpreter *interpreter, const struct redirection_plan *plan) {
+    struct function *function = find_function(interpreter->args[0]);
+    if (function != NULL) { //functions are checked first, so that they can replace commands
+        return call_function(interpreter, function, plan);
+    }
+
+    if (check_internal_command(interpreter->args[0]) != -1) { //check for internal commands
+        return execute_internal_command(interpreter, interpreter->args[0], plan);
+    }
+
+    //if it is not an internal command, then it must be an external command
+    execute_external_command(interpreter, plan);
+
+    return 0;
+}
+
+//function which runs a command, pipeline, if or loop and prints the real, user and sys time it took
+//the real time comes from CLOCK_MONOTONIC and the CPU times include both the shell and its children,
+//so internal commands such as 'source', which run inside the shell, are measured as well
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int execute_timed_command(struct interpreter *interpreter, struct node *node) {
+    struct rusage shell_before, children_before, shell_after, children_after;
+
+    getrusage(RUSAGE_SELF, &shell_before);
+    getrusage(RUSAGE_CHILDREN, &children_before);
+    double start_time = get_monotonic_time();
+
+    int exit_terminal = evaluate_compound_node(interpreter, node);
+
+    double real_time = get_monotonic_time() - start_time;
+    getrusage(RUSAGE_SELF, &shell_after);
+    getrusage(RUSAGE_CHILDREN, &children_after);
+
+    double user_time = timeval_to_seconds(shell_after.ru_utime) - timeval_to_seconds(shell_before.ru_utime) +
+                       timeval_to_seconds(children_after.ru_utime) - timeval_to_seconds(children_before.ru_utime);
+    double system_time = timeval_to_seconds(shell_after.ru_stime) - timeval_to_seconds(shell_before.ru_stime) +
+                         timeval_to_seconds(children_after.ru_stime) - timeval_to_seconds(children_before.ru_stime);
+
+    //the times are printed to STDERR so that they are not mixed into redirected output
+    fflush(stdout);
+    fprintf(stderr, "\nreal\t%.9fs\nuser\t%.6fs\nsys\t%.6fs\n", real_time, user_time, system_time);
+
+    return exit_terminal;
+}
+
+//function which executes an internal command depending on the first argument
+//the function also take care of redirection, which is done inside the shell without forking
+//returns 1 is 'exit' is entered, returns 0 otherwise
+int execute_internal_command(struct interpreter *interpreter, const char command[],
+                             const struct redirection_plan *plan) {
+    int exit_terminal = 0;
+    int exit_code = 0;
+    struct fd_action *saved_fds = NULL;
+
+    //make the redirections in the shell, the file descriptors are put back once the command is done
+    if (plan != NULL && plan->action_count > 0) {
+        saved_fds = apply_redirections_in_shell(plan);
+        if (saved_fds == NULL) {
+            set_exit_code(EXIT_FAILURE);
+            return 0;
+        }
+    }
+
+    //check which internal command is called
+    if (strcasecmp(command, "exit") == 0) {
+        exit_code = exit_command(interpreter);
+        exit_terminal = 1;
+    } else if (strcasecmp(command, "print") == 0) {
+        if (interpreter->arg_count == 1 &&
+            (interpreter->print_words == NULL || interpreter->print_words->token_count == 0)) {
+            printf("Invalid input!\n");
+            exit_code = EXIT_FAILURE;
+        } else {
+            print_command(interpreter);
+        }
+    } else if (strcasecmp(command, "chdir") == 0) {
+        //check the input is valid
+        if (interpreter->arg_count == 1) {
+            printf("Invalid input!\n");
+            exit_code = EXIT_FAILURE;
+        } else {
+            //execute the chdir command
+            exit_code = change_directory(interpreter->args[1]);
+        }
+    } else if (strcasecmp(command, "all") == 0) {
+        //print all the standard shell variables and all the user created variables
+        print_standard_variables();
+        print_user_variables();
+    } else if (strcasecmp(command, "source") == 0) {
+        if (interpreter->arg_count == 1) {
+            printf("Invalid input!\n");
+            exit_code = EXIT_FAILURE;
+        } else {
+            //the script runs in the shell, so the variables it sets are kept
+            //the exit code is the one of the last command in the script
+            get_input_from_file(interpreter, interpreter->args[1]);
+            exit_code = EXITCODE;
+        }
+    } else if (strcasecmp(command, "hash") == 0) {
+        exit_code = hash_command(interpreter);
+    } else if (strcasecmp(command, "jobs") == 0) {
+        jobs_command();
+    } else if (strcasecmp(command, "wait") == 0) {
+        wait_command(interpreter);
+        exit_code = EXITCODE;
+    } else if (strcasecmp(command, "times") == 0) {
+        times_command();
+    } else if (strcasecmp(command, "export") == 0) {
+        exit_code = export_command(interpreter);
+    } else if (strcasecmp(command, "unset") == 0) {
+        exit_code = unset_command(interpreter);
+    } else if (strcasecmp(command, "args") == 0) {
+        exit_terminal = args_command(interpreter);
+        exit_code = EXITCODE;
+    } else if (strcasecmp(command, "return") == 0) {
+        exit_code = return_command(interpreter);
+    }
+
+    //put back the original file descriptors if they were redirected
+    if (saved_fds != NULL) {
+        restore_redirections_in_shell(saved_fds, plan->action_count);
+    }
+
+    //EXITCODE is only changed after the command, so that 'print $EXITCODE' shows the previous one
+    set_exit_code(exit_code);
+
+    return exit_terminal;
+}
+
+//function which expands the targets of the redirections of a command and opens their files in the shell
+//the files are opened with O_CLOEXEC, so only the copies made by the actions are passed on to a command
+//returns 0 if every redirection could be made, returns 1 otherwise
+int prepare_redirections(struct interpreter *interpreter, struct redirection *redirections,
+                         struct redirection_plan *plan) {
+    int redirection_count = 0;
+
+    for (struct redirection *redirection = redirections; redirection != NULL; redirection = redirection->next) {
+        redirection_count++;
+    }
+
+    //'&>' and '&>>' change two file descriptors
+    plan->actions = arena_alloc(2 * redirection_count * sizeof(struct fd_action) + 1);
+    plan->opened_fds = arena_alloc(redirection_count * sizeof(int) + 1);
+    plan->action_count = 0;
+    plan->opened_count = 0;
+
+    for (struct redirection *redirection = redirections; redirection != NULL; redirection = redirection->next) {
+        interpreter->expansion_failed = 0;
+        char *target = expand_word(interpreter, redirection->target);
+        if (interpreter->expansion_failed) {
+            interpreter->expansion_failed = 0;
+            close_redirection_files(plan);
+            return 1;
+        }
+        int output = redirection->type == TOKEN_REDIRECT_OUT || redirection->type == TOKEN_REDIRECT_APPEND ||
+                     redirection->type == TOKEN_DUP_OUT || redirection->type == TOKEN_OUT_ALL ||
+                     redirection->type == TOKEN_APPEND_ALL;
+        int fd = redirection->fd >= 0 ? redirection->fd : (output ? STDOUT_FILENO : STDIN_FILENO);
+        int open_flags = -1;
+        int source_fd = -1;
+        int both_outputs = 0;
+
+        switch (redirection->type) {
+            case TOKEN_REDIRECT_OUT:
+                open_flags = O_WRONLY | O_CREAT | O_TRUNC;
+                break;
+            case TOKEN_REDIRECT_APPEND:
+                open_flags = O_WRONLY | O_CREAT | O_APPEND;
+                break;
+            case TOKEN_REDIRECT_IN:
+                open_flags = O_RDONLY;
+                break;
+            case TOKEN_READ_WRITE:
+                open_flags = O_RDWR | O_CREAT;
+                break;
+            case TOKEN_OUT_ALL:
+                open_flags = O_WRONLY | O_CREAT | O_TRUNC;
+                both_outputs = 1;
+                break;
+            case TOKEN_APPEND_ALL:
+                open_flags = O_WRONLY | O_CREAT | O_APPEND;
+                both_outputs = 1;
+                break;
+            case TOKEN_HERE_STRING: {
+                //the word is followed by a new line
+                size_t length = strlen(target);
+                char *here_string = arena_alloc(length + 2);
+                memcpy(here_string, target, length);
+                here_string[length] = '\n';
+                here_string[length + 1] = '\0';
+                source_fd = open_here_document(here_string, length + 1);
+                break;
+            }
+            case TOKEN_HERE_DOCUMENT:
+                source_fd = open_here_document(target, strlen(target));
+                break;
+            case TOKEN_DUP_OUT:
+            case TOKEN_DUP_IN:
+                //'N>&M' copies M onto N, and 'N>&-' closes N
+                if (strcmp(target, "-") == 0) {
+                    source_fd = -1;
+                } else if ((source_fd = parse_fd_number(target)) < 0) {
+                    //'>& file' without a file descriptor is the same as '&> file'
+                    if (redirection->type == TOKEN_DUP_OUT && redirection->fd < 0) {
+                        open_flags = O_WRONLY | O_CREAT | O_TRUNC;
+                        both_outputs = 1;
+                    } else {
+                        fprintf(stderr, "%s: ambiguous redirect\n", target);
+                        close_redirection_files(plan);
+                        return 1;
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (open_flags >= 0) {
+            source_fd = open(target, open_flags | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+            if (source_fd < 0) {
+                fprintf(stderr, "Cannot open file %s: %s\n", target, strerror(errno));
+                close_redirection_files(plan);
+                return 1;
+            }
+        }
+
+        //files and here-documents are opened by the shell, file descriptors which are copied are not
+        if (open_flags >= 0 || redirection->type == TOKEN_HERE_STRING || redirection->type == TOKEN_HERE_DOCUMENT) {
+            if (source_fd < 0) {
+                close_redirection_files(plan);
+                return 1;
+            }
+            plan->opened_fds[plan->opened_count++] = source_fd;
+        }
+
+        plan->actions[plan->action_count].target_fd = both_outputs ? STDOUT_FILENO : fd;
+        plan->actions[plan->action_count].source_fd = source_fd;
+        plan->action_count++;
+
+        if (both_outputs) {
+            plan->actions[plan->action_count].target_fd = STDERR_FILENO;
+            plan->actions[plan->action_count].source_fd = source_fd;
+            plan->action_count++;
+        }
+    }
+
+    return 0;
+}
+
+//function which reads a file descriptor number such as the 1 in '2>&1'
+//returns the number, or -1 if the input is not a number
+int parse_fd_number(const char input[]) {
+    if (input[0] == '\0' || strspn(input, "0123456789") != strlen(input) || strlen(input) > 9) {
+        return -1;
+    }
+
+    return atoi(input);
+}
+
+//function which closes the files opened by prepare_redirections, once the command has been started
+void close_redirection_files(const struct redirection_plan *plan) {
+    for (int i = 0; i < plan->opened_count; i++) {
+        close(plan->opened_fds[i]);
+    }
+}
+
+//function which makes the redirections in the shell itself, used for internal commands
+//every file descriptor which is changed is first copied, so that it can be put back
+//returns the copies to pass to restore_redirections_in_shell, or NULL if a redirection failed
+struct fd_action *apply_redirections_in_shell(const struct redirection_plan *plan) {
+    struct fd_action *saved_fds = arena_alloc(plan->action_count * sizeof(struct fd_action));
+
+    //write out anything still buffered before switching
+    fflush(stdout);
+    fflush(stderr);
+
+    for (int i = 0; i < plan->action_count; i++) {
+        int target_fd = plan->actions[i].target_fd;
+        int source_fd = plan->actions[i].source_fd;
+
+        //only the first change to a file descriptor keeps a copy, -2 means there is nothing to put back
+        saved_fds[i].target_fd = target_fd;
+        saved_fds[i].source_fd = -2;
+        for (int j = 0; j < i && saved_fds[i].source_fd == -2; j++) {
+            if (saved_fds[j].target_fd == target_fd) {
+                saved_fds[i].source_fd = -3;
+            }
+        }
+        if (saved_fds[i].source_fd == -2) {
+            //-1 means the file descriptor was not open, so it is closed again afterwards
+            saved_fds[i].source_fd = fcntl(target_fd, F_DUPFD_CLOEXEC, 10);
+        }
+
+        if (source_fd < 0) {
+            close(target_fd);
+        } else if (source_fd != target_fd && dup2(source_fd, target_fd) < 0) {
+            perror("Unable to redirect");
+            restore_redirections_in_shell(saved_fds, i + 1);
+            return NULL;
+        }
+    }
+
+    return saved_fds;
+}
+
+//function which puts back the file descriptors changed by apply_redirections_in_shell, in reverse order
+void restore_redirections_in_shell(struct fd_action saved_fds[], int count) {
+    fflush(stdout);
+    fflush(stderr);
+
+    for (int i = count - 1; i >= 0; i--) {
+        if (saved_fds[i].source_fd >= 0) {
+            dup2(saved_fds[i].source_fd, saved_fds[i].target_fd);
+            close(saved_fds[i].source_fd);
+        } else if (saved_fds[i].source_fd == -1) {
+            close(saved_fds[i].target_fd);
+        }
+    }
+}
+
+//function which makes the redirections in a forked child
+//returns 0 if every redirection was made, returns 1 otherwise
+int apply_redirections_in_child(const struct redirection_plan *plan) {
+    for (int i = 0; i < plan->action_count; i++) {
+        if (plan->actions[i].source_fd < 0) {
+            close(plan->actions[i].target_fd);
+        } else if (plan->actions[i].source_fd != plan->actions[i].target_fd &&
+                   dup2(plan->actions[i].source_fd, plan->actions[i].target_fd) < 0) {
+            perror("Unable to redirect");
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+//function which runs a command with the words read from STDIN added to its arguments, similar to xargs
+//'args print < file' prints the words in the file, the file is read in blocks so it has no size limit
+//returns 1 if 'exit' is entered, returns 0 otherwise
+int args_command(struct interpreter *interpreter) {
+    size_t length = 0;
+    size_t capacity = MAX_LENGTH;
+    char *input = arena_alloc(capacity);
+    ssize_t read_count;
+
+    if (interpreter->arg_count == 1) {
+        printf("Invalid input!\n");
+        set_exit_code(EXIT_FAILURE);
+        return 0;
+    }
+
+    //read the whole of STDIN, growing the buffer when it is full
+    while ((read_count = read(STDIN_FILENO, &input[length], capacity - length - 1)) != 0) {
+        if (read_count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("args: cannot read input");
+            set_exit_code(EXIT_FAILURE);
+            return 0;
+        }
+
+        length += (size_t) read_count;
+        if (length == capacity - 1) {
+            input = arena_grow(input, capacity, capacity * 2);
+            capacity *= 2;
+        }
+    }
+    input[length] = '\0';
+
+    char **command_args = interpreter->args;
+    int command_count = interpreter->arg_count;
+
+    //the input is data and not shell code, so like xargs it is only split into words on blanks and new lines
+    //nothing in it is expanded, quoted or run, the words are terminated in place
+    int word_count = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (isspace((unsigned char) input[i])) {
+            input[i] = '\0';
+        } else if (input[i] != '\0' && (i == 0 || input[i - 1] == '\0')) {
+            word_count++;
+        }
+    }
+
+    //the arguments are the command after 'args' followed by the words which were read
+    char **new_args = arena_alloc(((size_t) command_count + word_count) * sizeof(char *));
+    memcpy(new_args, &command_args[1], ((size_t) command_count - 1) * sizeof(char *));
+
+    int arg_count = command_count - 1;
+    for (size_t i = 0; i < length; i++) {
+        if (input[i] != '\0' && (i == 0 || input[i - 1] == '\0')) {
+            new_args[arg_count++] = &input[i];
+        }
+    }
+    new_args[arg_count] = NULL;
+
+    interpreter->args = new_args;
+    interpreter->arg_count = arg_count;
+
+    return execute_command(interpreter, NULL);
+}
+
+//function which prints the input, similar to echo
+//quotes and variables have already been handled when the input was expanded
+void print_command(struct interpreter *interpreter) {
+    //the words of a 'print' run in the shell are printed one at a time as they are expanded
+    //the source is cleared once it is taken, since it belongs to this command only
+    struct word_source *words = interpreter->print_words;
+    interpreter->print_words = NULL;
+    if (words != NULL) {
+        char *word;
+        for (int i = 0; (word = next_word(words)) != NULL; i++) {
+            printf("%s%s", i > 0 ? " " : "", word);
+        }
+        printf("\n");
+        return;
+    }
+
+    for (int i = 1; i < interpreter->arg_count; i++) {
+        printf("%s%s", interpreter->args[i], i < interpreter->arg_count - 1 ? " " : "");
+    }
+
+    printf("\n");
+}
+
+//function which checks the CWD and the given path and changes it, if it is valid
+//returns 0 if the directory was changed, returns 1 otherwise
+int change_directory(char path[]) {
+    int exit_code = 0;
+
+    //check is .. was entered
+    if (strcasecmp(path, "..") != 0) {
+        //check if the path is valid
+        if (chdir(path) != 0) {
+            perror("Cannot change directory");
+            exit_code = EXIT_FAILURE;
+        } else { //if the path is valid, change the variable CWD
+            invalidate_cwd();
+        }
+    } else { //if .. was entered
+        //remove everything from the last / in a copy of CWD, the root directory is kept as it is
+        char *cwd = get_variable_value("CWD");
+        char *parent = arena_strndup(cwd, strlen(cwd));
+        char *last_slash = strrchr(parent, '/');
+        if (last_slash != NULL) {
+            last_slash[last_slash == parent ? 1 : 0] = '\0';
+        }
+
+        //check if the new path is valid, CWD is only changed if it is
+        if (chdir(parent) != 0) {
+            perror("Cannot change directory");
+            exit_code = EXIT_FAILURE;
+        } else { //if the path is valid, change the variable CWD
+            invalidate_cwd();
+        }
+    }
+
+    return exit_code;
+}
+
+//function which launches an external command and waits for it to finish
+void execute_external_command(struct interpreter *interpreter, const struct redirection_plan *plan) {
+    int wait_val;
+    struct launch_options options = {-1, -1, plan, -1};
+
+    double start_time = get_monotonic_time();
+    start_command_usage();
+
+    pid_t pid = launch_external_command(interpreter->args, &options);
+
+    if (pid < 0) {
+        EXITCODE = launch_failure_status(errno);
+    } else {
+        //wait4 also returns the resources used by the child
+        struct rusage usage;
+        wait4(pid, &wait_val, 0, &usage);
+        add_command_usage(&usage);
+
+        EXITCODE = wait_status_to_exit_code(wait_val);
+    }
+
+    finish_command_usage(start_time);
+
+    set_exit_code(EXITCODE);
+}
+
+//function which returns a file descriptor to read the given text from, without blocking the shell
+//text which fits in a pipe is written to a pipe and the write end is closed straight away,
+//longer text is written to an anonymous file from memfd_create, which is then read from the start
+//returns the file descriptor, or -1 if it could not be created
+int open_here_document(const char body[], size_t length) {
+    int pipe_fds[2];
+
+    if (pipe2(pipe_fds, O_CLOEXEC) == 0) {
+        int pipe_size = fcntl(pipe_fds[1], F_GETPIPE_SZ);
+
+        if (pipe_size > 0 && length <= (size_t) pipe_size) {
+            if (length == 0 || write(pipe_fds[1], body, length) == (ssize_t) length) {
+                close(pipe_fds[1]);
+                return pipe_fds[0];
+            }
+        }
+
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+    }
+
+    int fd = memfd_create("eggsh-here-document", MFD_CLOEXEC);
+    if (fd < 0) {
+        perror("Unable to create here-document");
+        return -1;
+    }
+
+    size_t written = 0;
+    while (written < length) {
+        ssize_t write_count = write(fd, &body[written], length - written);
+        if (write_count < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            perror("Unable to write here-document");
+            close(fd);
+            return -1;
+        }
+        written += (size_t) write_count;
+    }
+
+    lseek(fd, 0, SEEK_SET);
+
+    return fd;
+}
+
+//function which starts an external command without waiting for it
+//posix_spawn is used by default, the fork-plus-exec path is kept as a fallback
+//returns the pid of the child, or -1 if the command could not be launched
+pid_t launch_external_command(char *argv[], const struct launch_options *options) {
+    pid_t pid = -1;
+
+    //find the command in PATH, or in the table of commands which have already been found
+    char *path = get_command_path(argv[0]);
+
+    if (path == NULL) {
+        errno = ENOENT;
+        perror("Exec failed");
+        errno = ENOENT;
+        return -1;
+    }
+
+    //write out what the shell has printed so far, so that it comes before the output of the command
+    //without a terminal stdout is fully buffered and would otherwise be written when the shell exits
+    fflush(stdout);
+
+    if (USE_POSIX_SPAWN) {
+        pid = spawn_external_command(path, argv, options);
+
+        //if posix_spawn is not supported, fall back to fork-plus-exec
+        if (pid < 0 && errno == ENOSYS) {
+            USE_POSIX_SPAWN = 0;
+        } else if (pid < 0) {
+            int error = errno;
+            perror("Exec failed");
+            errno = error;
+        }
+    }
+
+    if (!USE_POSIX_SPAWN) {
+        pid = fork_external_command(path, argv, options);
+
+        if (pid < 0) {
+            int error = errno;
+            perror("Unable to fork");
+            errno = error;
+        }
+    }
+
+    return pid;
+}
+
+//function which returns the exit status for a command which could not be launched
+//a command which cannot be found gives 127 and a file which cannot be executed gives 126
+int launch_failure_status(int error) {
+    if (error == ENOENT || error == ENOTDIR) {
+        return 127;
+    }
+
+    if (error == EACCES || error == ENOEXEC || error == EISDIR || error == EPERM) {
+        return 126;
+    }
+
+    return EXIT_FAILURE;
+}
+
+//function which turns a status from wait into an exit code
+//a child killed by a signal gives 128 plus the number of the signal
+int wait_status_to_exit_code(int wait_val) {
+    if (WIFSIGNALED(wait_val)) {
+        return 128 + WTERMSIG(wait_val);
+    }
+
+    return WIFEXITED(wait_val) ? WEXITSTATUS(wait_val) : EXIT_FAILURE;
+}
+
+//function which launches an external command through posix_spawn
+//redirection and pipes are expressed as spawn file actions, so the shell is never duplicated
+//returns the pid of the child, or -1 with errno set if the command could not be launched
+pid_t spawn_external_command(const char path[], char *argv[], const struct launch_options *options) {
+    pid_t pid;
+    posix_spawn_file_actions_t file_actions;
+    posix_spawnattr_t attributes;
+
+    posix_spawn_file_actions_init(&file_actions);
+    posix_spawnattr_init(&attributes);
+
+    //connect the ends of the pipes to STDIN and STDOUT in the child
+    if (options->stdin_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&file_actions, options->stdin_fd, STDIN_FILENO);
+    }
+
+    if (options->stdout_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&file_actions, options->stdout_fd, STDOUT_FILENO);
+    }
+
+    //make the redirections of the command after the pipes, in the order they were written
+    for (int i = 0; options->plan != NULL && i < options->plan->action_count; i++) {
+        if (options->plan->actions[i].source_fd < 0) {
+            posix_spawn_file_actions_addclose(&file_actions, options->plan->actions[i].target_fd);
+        } else {
+            posix_spawn_file_actions_adddup2(&file_actions, options->plan->actions[i].source_fd,
+                                             options->plan->actions[i].target_fd);
+        }
+    }
+
+    //move the child into the requested process group
+    if (options->pgid >= 0) {
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setpgroup(&attributes, options->pgid);
+    }
+
+    //the path has already been resolved, so there is no need to search PATH again
+    int spawn_val = posix_spawn(&pid, path, &file_actions, &attributes, argv, ENVP);
+
+    posix_spawn_file_actions_destroy(&file_actions);
+    posix_spawnattr_destroy(&attributes);
+
+    if (spawn_val != 0) {
+        errno = spawn_val;
+        return -1;
+    }
+
+    return pid;
+}
+
+//function which forks the shell and sets up the child as described by the launch options
+//returns the pid of the child in the parent, 0 in the child and -1 if the fork failed
+pid_t fork_with_options(const struct launch_options *options) {
+    //flush any pending output so that it is not written twice
+    fflush(stdout);
+
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        //join the requested process group
+        if (options->pgid >= 0) {
+            setpgid(0, options->pgid);
+        }
+
+        //connect the ends of the pipes to STDIN and STDOUT
+        if (options->stdin_fd >= 0) {
+            dup2(options->stdin_fd, STDIN_FILENO);
+        }
+
+        if (options->stdout_fd >= 0) {
+            dup2(options->stdout_fd, STDOUT_FILENO);
+        }
+
+        //make the redirections of the command after the pipes
+        if (options->plan != NULL && apply_redirections_in_child(options->plan) != 0) {
+            _exit(EXIT_FAILURE);
+        }
+    } else if (pid > 0 && options->pgid >= 0) {
+        //also set the process group from the parent, so that it is set whichever process runs first
+        setpgid(pid, options->pgid == 0 ? pid : options->pgid);
+    }
+
+    return pid;
+}
+
+//function to run a simple fork-plus-exec to execute external commands
+//returns the pid of the child, or -1 if the fork failed
+pid_t fork_external_command(const char path[], char *argv[], const struct launch_options *options) {
+    //fork the main branch
+    pid_t pid = fork_with_options(options);
+
+    //check if the fork was valid
+    if (pid == 0) { //if the fork is valid, check if it is in the child
+        //execute external command from the path which has already been resolved
+        if (execve(path, argv, ENVP)) {
+            int error = errno;
+            perror("Exec failed");
+            _exit(launch_failure_status(error));
+        }
+    }
+
+    return pid;
+}
+
+//function which runs an internal command or a function in a child process, used for stages of a pipeline
+//returns the pid of the child, or -1 if the fork failed
+pid_t fork_internal_command(struct interpreter *interpreter, char *argv[], const struct launch_options *options) {
+    pid_t pid = fork_with_options(options);
+
+    if (pid < 0) {
+        perror("Unable to fork");
+    } else if (pid == 0) {
+        //the child does not exec, so the pipes of the other stages have to be closed here
+        close_cloexec_fds();
+
+        //the arguments of this stage become the arguments of the interpreter
+        int argc = 0;
+        while (argv[argc] != NULL) {
+            argc++;
+        }
+        interpreter->args = argv;
+        interpreter->arg_count = argc;
 
-            wait(NULL);
-        } else { //if the output is not redirected, excute print normally
-            print_command();
+        execute_command(interpreter, NULL);
+
+        //_exit is used so that the streams shared with the shell, such as a sourced file, are left untouched
+        fflush(stdout);
+        _exit(EXITCODE);
+    }
+
+    return pid;
+}
+
+//function which closes every file descriptor which would be closed by exec, used in children which do not exec
+void close_cloexec_fds() {
+    DIR *fd_directory = opendir("/proc/self/fd");
+
+    if (fd_directory == NULL) {
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(fd_directory)) != NULL) {
+        int fd = atoi(entry->d_name);
+        int flags;
+
+        if (fd > STDERR_FILENO && fd != dirfd(fd_directory) && (flags = fcntl(fd, F_GETFD)) >= 0 &&
+            (flags & FD_CLOEXEC)) {
+            close(fd);
         }
-    } else if (strcasecmp(command, "chdir") == 0) {
-        //check the input is valid
-        if (INPUT_ARGS_COUNT == 1) {
-            printf("Invalid input!\n");
-            return 0;
+    }
+
+    closedir(fd_directory);
+}
+
+//function which gives control of the terminal to a process group
+//this is only done if the shell is interactive and its input is still the terminal
+void give_terminal_to(pid_t pgid) {
+    sigset_t block_set, old_set;
+
+    if (!INTERACTIVE || !isatty(STDIN_FILENO)) {
+        return;
+    }
+
+    //block SIGTTOU, otherwise the shell is stopped when taking the terminal back from the background
+    sigemptyset(&block_set);
+    sigaddset(&block_set, SIGTTOU);
+    sigprocmask(SIG_BLOCK, &block_set, &old_set);
+
+    tcsetpgrp(STDIN_FILENO, pgid);
+
+    sigprocmask(SIG_SETMASK, &old_set, NULL);
+}
+
+//function which runs every command of a pipeline such as 'a | b | c' at the same time
+//all the pipes are created first, and every stage is put in one process group
+//the exit code of the last stage is stored in EXITCODE
+//if background is 1, the pipeline is added to the job table instead of waiting for it
+void execute_pipeline(struct interpreter *interpreter, struct node *pipeline, int background) {
+    int stage_count = 1;
+    char *command = NULL;
+    pid_t pgid = 0;
+    int input_fd = -1;
+    sigset_t old_set;
+
+    //the pipe nodes form a chain to the left, so the stages are collected from the right
+    for (struct node *node = pipeline; node->type == NODE_PIPE; node = node->left) {
+        stage_count++;
+    }
+
+    //the arrays for the stages are allocated from the line arena, so there is no limit on the number of stages
+    struct node **stage_nodes = arena_alloc(stage_count * sizeof(struct node *));
+    char ***stages = arena_alloc(stage_count * sizeof(char **));
+    pid_t *pids = arena_alloc(stage_count * sizeof(pid_t));
+    int *statuses = arena_alloc(stage_count * sizeof(int));
+    int (*pipes)[2] = arena_alloc(stage_count * sizeof(int[2]));
+    struct redirection_plan *plans = arena_alloc(stage_count * sizeof(struct redirection_plan));
+    struct word_source *print_words = arena_alloc(stage_count * sizeof(struct word_source));
+
+    struct node *node = pipeline;
+    for (int i = stage_count - 1; i >= 0; i--) {
+        stage_nodes[i] = node->type == NODE_PIPE ? node->right : node;
+        node = node->left;
+    }
+
+    //expand every stage into its own list of arguments and open the files of its redirections
+    GLOB_CACHE = NULL;
+    for (int i = 0; i < stage_count; i++) {
+        //a 'print' stage expands its words in the child as it prints them, like 'print' in the shell
+        int print_stage = is_lazy_print(stage_nodes[i]);
+        if (print_stage) {
+            start_word_source(interpreter, &print_words[i], &stage_nodes[i]->words[1], stage_nodes[i]->word_count - 1);
+            interpreter->args = arena_alloc(2 * sizeof(char *));
+            interpreter->args[0] = stage_nodes[i]->words[0].text;
+            interpreter->args[1] = NULL;
+        } else {
+            print_words[i].tokens = NULL;
         }
-        //execute the chdir command
-        change_directory(ARGS[1]);
-    } else if (strcasecmp(command, "all") == 0) {
-        //if the '>' redirection argument is used, redirect the output to the file
-        if (redirect == 1) {
-            char filename[MAX_LENGTH];
-            strncpy(filename, ARGS[INPUT_ARGS_COUNT - 1], strlen(ARGS[INPUT_ARGS_COUNT - 1]));
 
-            //fork the main branch to be able to redirect the output smoothly
-            pid_t pid = fork();
+        if ((!print_stage && expand_tokens(interpreter, stage_nodes[i]->words, stage_nodes[i]->word_count) < 0) ||
+            prepare_redirections(interpreter, stage_nodes[i]->redirections, &plans[i]) != 0) {
+            for (int j = 0; j < i; j++) {
+                close_redirection_files(&plans[j]);
+            }
+            set_exit_code(EXIT_FAILURE);
+            return;
+        }
 
-            if (pid < 0) {
-                perror("Unable to fork");
-                exit(EXIT_FAILURE);
-            } else if (pid == 0) {
-                //open the file in read-write-truncate mode and create it if it is not found
-                int fd = open(filename, O_RDWR | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR | S_IXUSR);
-                if (fd > 0) {
-                    //redirect STDOUT to the file
-                    dup2(fd, 1);
-                    //print all the standard shell variables
-                    print_standard_variables();
-                    //print al lthe user created variables
-                    print_user_variables();
-                    //close the file
-                    close(fd);
-                    exit(EXIT_SUCCESS);
-                } else {
-                    perror("Unable to open file");
-                    exit(EXIT_FAILURE);
-                }
+        stages[i] = interpreter->args;
+    }
+
+    //keep the input as it was entered, to show it in the job table
+    if (background) {
+        size_t command_length = 1;
+        for (int i = 0; i < stage_count; i++) {
+            for (int j = 0; j < stage_nodes[i]->token_count; j++) {
+                command_length += stage_nodes[i]->tokens[j].length + 3;
             }
+        }
 
-            wait(NULL);
-        } else if (redirect == 2) { //if the '>>' redirection argument is used, redirect the output to the file
-            char filename[MAX_LENGTH];
-            strncpy(filename, ARGS[INPUT_ARGS_COUNT - 1], strlen(ARGS[INPUT_ARGS_COUNT - 1]));
+        command = arena_alloc(command_length);
+        command[0] = '\0';
+        for (int i = 0; i < stage_count; i++) {
+            for (int j = 0; j < stage_nodes[i]->token_count; j++) {
+                strcat(command, stage_nodes[i]->tokens[j].text);
+                strcat(command, j < stage_nodes[i]->token_count - 1 ? " " : "");
+            }
+            strcat(command, i < stage_count - 1 ? " | " : "");
+        }
+    }
 
-            //fork the main branch to be able to redirect the output smoothly
-            pid_t pid = fork();
+    //create all the pipes up front, they are closed in the children when they exec
+    for (int i = 0; i < stage_count - 1; i++) {
+        if (pipe2(pipes[i], O_CLOEXEC) != 0) {
+            perror("Unable to create pipe");
+            for (int j = 0; j < i; j++) {
+                close(pipes[j][0]);
+                close(pipes[j][1]);
+            }
+            for (int j = 0; j < stage_count; j++) {
+                close_redirection_files(&plans[j]);
+            }
+            return;
+        }
+    }
 
-            if (pid < 0) {
-                perror("Unable to fork");
-                exit(EXIT_FAILURE);
-            } else if (pid == 0) {
-                //open the file in read-write-append mode
-                int fd = open(filename, O_RDWR | O_APPEND, S_IRUSR | S_IWUSR | S_IXUSR);
-                if (fd > 0) {
-                    //redirect STDOUT to the file
-                    dup2(fd, 1);
-                    //print all the standard shell variables
-                    print_standard_variables();
-                    //print al lthe user created variables
-                    print_user_variables();
-                    //close the file
-                    close(fd);
-                    exit(EXIT_SUCCESS);
-                } else {
-                    perror("Unable to open file");
-                    exit(EXIT_FAILURE);
-                }
+    if (background) {
+        //background jobs do not read from the terminal, unless the first stage redirects its input
+        input_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+        //the handler must not reap the processes before they are added to the job table
+        block_sigchld(&old_set);
+    }
+
+    double start_time = get_monotonic_time();
+    if (!background) {
+        start_command_usage();
+    }
+
+    //start every stage, the first stage creates the process group which the others join
+    for (int i = 0; i < stage_count; i++) {
+        struct launch_options options = {-1, -1, &plans[i], pgid};
+        statuses[i] = EXIT_FAILURE;
+
+        if (i > 0) {
+            options.stdin_fd = pipes[i - 1][0];
+        } else {
+            options.stdin_fd = input_fd;
+        }
+
+        if (i < stage_count - 1) {
+            options.stdout_fd = pipes[i][1];
+        }
+
+        if (check_internal_command(stages[i][0]) != -1 || find_function(stages[i][0]) != NULL) {
+            //the child gets a copy of the words of a 'print' stage
+            interpreter->print_words = print_words[i].tokens != NULL ? &print_words[i] : NULL;
+            pids[i] = fork_internal_command(interpreter, stages[i], &options);
+            interpreter->print_words = NULL;
+        } else {
+            pids[i] = launch_external_command(stages[i], &options);
+
+            if (pids[i] < 0) {
+                statuses[i] = launch_failure_status(errno);
             }
+        }
 
-            wait(NULL);
-        } else { //if the output is not redirected, output the variables normally to the terminal
-            print_standard_variables();
-            print_user_variables();
+        if (pids[i] > 0 && pgid == 0) {
+            pgid = pids[i];
+            if (!background) {
+                give_terminal_to(pgid);
+            }
         }
-    } else if (strcasecmp(command, "source") == 0) {
-        //if the '>' redirection argument is used, redirect the output to the file
-        if (redirect == 1) {
-            char filename[MAX_LENGTH];
-            strncpy(filename, ARGS[INPUT_ARGS_COUNT - 1], strlen(ARGS[INPUT_ARGS_COUNT - 1]));
+    }
 
-            //fork the main branch to be able to redirect the output smoothly
-            pid_t pid = fork();
+    //the shell does not use the pipes, so close them to let the stages see end of file
+    for (int i = 0; i < stage_count - 1; i++) {
+        close(pipes[i][0]);
+        close(pipes[i][1]);
+    }
 
-            if (pid < 0) {
-                perror("Unable to fork");
-                exit(EXIT_FAILURE);
-            } else if (pid == 0) {
-                //open the file in read-write-truncate mode and create it if it is not found
-                int fd = open(filename, O_RDWR | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR | S_IXUSR);
-                if (fd > 0) {
-                    //redirect STDOUT to the file
-                    dup2(fd, 1);
-                    //execute the source command
-                    get_input_from_file(ARGS[1]);
-                    //close the file
-                    close(fd);
-                    exit(EXIT_SUCCESS);
-                } else {
-                    perror("Unable to open file");
-                    exit(EXIT_FAILURE);
-                }
+    if (input_fd >= 0) {
+        close(input_fd);
+    }
+
+    for (int i = 0; i < stage_count; i++) {
+        close_redirection_files(&plans[i]);
+    }
+
+    if (background) {
+        if (pgid != 0) {
+            int job_id = add_job(pgid, pids, stage_count, command);
+
+            //only announce the job when the input is typed in the terminal
+            if (job_id > 0 && interpreter->source_depth == 0 && INTERACTIVE) {
+                printf("[%d] %d\n", job_id, pgid);
             }
+        }
 
-            wait(NULL);
-        } else if (redirect == 2) { //if the '>>' redirection argument is used, redirect the output to the file
-            char filename[MAX_LENGTH];
-            strncpy(filename, ARGS[INPUT_ARGS_COUNT - 1], strlen(ARGS[INPUT_ARGS_COUNT - 1]));
+        sigprocmask(SIG_SETMASK, &old_set, NULL);
 
-            //fork the main branch to be able to redirect the output smoothly
-            pid_t pid = fork();
+        set_exit_code(pgid != 0 ? 0 : EXIT_FAILURE);
+        return;
+    }
 
-            if (pid < 0) {
-                perror("Unable to fork");
-                exit(EXIT_FAILURE);
-            } else if (pid == 0) {
-                //open the file in read-write-append
-                int fd = open(filename, O_RDWR | O_APPEND, S_IRUSR | S_IWUSR | S_IXUSR);
-                if (fd > 0) {
-                    //redirect STDOUT to the file
-                    dup2(fd, 1);
-                    //execute the source command
-                    get_input_from_file(ARGS[1]);
-                    //close the file
-                    close(fd);
-                    exit(EXIT_SUCCESS);
-                } else {
-                    perror("Unable to open file");
-                    exit(EXIT_FAILURE);
-                }
+    //collect the exit status of every stage
+    for (int i = 0; i < stage_count; i++) {
+        if (pids[i] > 0) {
+            int wait_val;
+            struct rusage usage;
+            wait4(pids[i], &wait_val, 0, &usage);
+            add_command_usage(&usage);
+
+            statuses[i] = wait_status_to_exit_code(wait_val);
+        }
+    }
+
+    finish_command_usage(start_time);
+
+    if (pgid != 0) {
+        give_terminal_to(getpgrp());
+    }
+
+    set_exit_code(statuses[stage_count - 1]);
+}
+
+//function which returns a hash for the given string, used by the hash tables in the shell
+unsigned int hash_string(const char input[]) {
+    return hash_bytes(input, strlen(input));
+}
+
+//function which returns a hash for the first length characters of a string
+unsigned int hash_bytes(const char input[], size_t length) {
+    unsigned int hash = 5381;
+
+    for (size_t i = 0; i < length; i++) {
+        hash = hash * 33 + (unsigned char) input[i];
+    }
+
+    return hash;
+}
+
+//function which searches every directory in PATH for an executable with the given name
+//returns an allocated string with the absolute path, or NULL if the command is not found
+char *find_command_in_path(const char command[]) {
+    struct stat file_stat;
+    const char *dir_start = PATH;
+
+    //the candidate is sized for the longest entry of PATH, so that no directory or name is cut short
+    size_t candidate_size = strlen(PATH) + strlen(command) + 3;
+    char *candidate = malloc(candidate_size);
+    if (candidate == NULL) {
+        perror("Unable to allocate memory");
+        exit(EXIT_FAILURE);
+    }
+
+    while (*dir_start != '\0') {
+        const char *dir_end = strchr(dir_start, ':');
+        int dir_length = dir_end == NULL ? (int) strlen(dir_start) : (int) (dir_end - dir_start);
+
+        //an empty entry in PATH means the current directory
+        if (dir_length == 0) {
+            snprintf(candidate, candidate_size, "./%s", command);
+        } else {
+            snprintf(candidate, candidate_size, "%.*s/%s", dir_length, dir_start, command);
+        }
+
+        if (stat(candidate, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && access(candidate, X_OK) == 0) {
+            return candidate;
+        }
+
+        if (dir_end == NULL) {
+            break;
+        }
+
+        dir_start = dir_end + 1;
+    }
+
+    free(candidate);
+
+    return NULL;
+}
+
+//function which returns the path used to execute a command
+//commands containing a / are used as they are, other commands are looked up in the hash table first
+//if the remembered path no longer exists the command is searched for in PATH again
+//returns NULL if the command cannot be found
+char *get_command_path(const char command[]) {
+    if (strchr(command, '/') != NULL) {
+        return (char *) command;
+    }
+
+    unsigned int bucket = hash_string(command) % COMMAND_HASH_SIZE;
+    struct command_hash_entry **entry = &COMMAND_HASH[bucket];
+
+    while (*entry != NULL) {
+        if (strcmp((*entry)->name, command) == 0) {
+            if (access((*entry)->path, X_OK) == 0) {
+                (*entry)->hits++;
+                return (*entry)->path;
             }
 
-            wait(NULL);
-        } else { //if the output is not redirected, output to the terminal
-            get_input_from_file(ARGS[1]);
+            //the remembered path is stale, so remove the entry and search again
+            struct command_hash_entry *stale = *entry;
+            *entry = stale->next;
+            free(stale->name);
+            free(stale->path);
+            free(stale);
+            break;
         }
+
+        entry = &(*entry)->next;
     }
 
-    return exit_terminal;
+    char *path = find_command_in_path(command);
+
+    if (path == NULL) {
+        return NULL;
+    }
+
+    //remember the path for the next time the command is used
+    struct command_hash_entry *new_entry = malloc(sizeof(struct command_hash_entry));
+    new_entry->name = strdup(command);
+    new_entry->path = path;
+    new_entry->hits = 1;
+    new_entry->next = COMMAND_HASH[bucket];
+    COMMAND_HASH[bucket] = new_entry;
+
+    return path;
 }
 
-//function which prints the input, similar to echo
-void print_command() {
-    int quotes_num = 0;
-    int print_literal = 0;
+//function which removes all the remembered command paths
+void clear_command_hash() {
+    for (int i = 0; i < COMMAND_HASH_SIZE; i++) {
+        while (COMMAND_HASH[i] != NULL) {
+            struct command_hash_entry *entry = COMMAND_HASH[i];
+            COMMAND_HASH[i] = entry->next;
+            free(entry->name);
+            free(entry->path);
+            free(entry);
+        }
+    }
+}
 
-    //check for only one word with two ""
-    if (ARGS[1][0] == '"' && ARGS[1][strlen(ARGS[1]) - 1] == '"' && strlen(ARGS[1]) > 1) {
-        printf("%.*s\n", (int) (strlen(ARGS[1]) - 2), &ARGS[1][1]);
-        return;
+//function which prints all the remembered command paths and how many times they were used
+void print_command_hash() {
+    int empty = 1;
+
+    for (int i = 0; i < COMMAND_HASH_SIZE; i++) {
+        for (struct command_hash_entry *entry = COMMAND_HASH[i]; entry != NULL; entry = entry->next) {
+            if (empty) {
+                printf("hits\tcommand\n");
+                empty = 0;
+            }
+            printf("%4d\t%s\n", entry->hits, entry->path);
+        }
     }
 
-    for (int i = 1; i < INPUT_ARGS_COUNT; i++) {
-        //check for a single " in the start of each ARG
-        if (ARGS[i][0] == '"') {
-            quotes_num++;
-        }
-
-        //check for a single " in the end of each ARG
-        if (strlen(ARGS[i]) > 1) {
-            if (ARGS[i][strlen(ARGS[i]) - 1] == '"') {
-                quotes_num++;
-            }
-        }
-    }
-
-    //check if the number of quotes in the input is less then 2
-    if (quotes_num < 2) {
-        for (int i = 1; i < INPUT_ARGS_COUNT; i++) {
-            //checking for only "
-            if (strcasecmp(ARGS[i], "\"") != 0) {
-                //check for " at beginning of word
-                if (ARGS[i][0] == '"') {
-                    //check for $ after "
-                    if (ARGS[i][1] == '$') {
-                        //check for a punctuation mark exactly at the end of '$VAR'
-                        if (ARGS[i][(int) strlen(ARGS[i]) - 1] == ',' ||
-                            ARGS[i][(int) strlen(ARGS[i]) - 1] == '.' ||
-                            ARGS[i][(int) strlen(ARGS[i]) - 1] == '!' ||
-                            ARGS[i][(int) strlen(ARGS[i]) - 1] == '?') {
-                            //if the variable is found print the value of the variable with the punctuation mark at the end
-                            if (strcasecmp(get_value_after_dollar(&ARGS[i][1], (int) strlen(ARGS[i]) - 2), "") != 0) {
-                                printf("%s%c ", get_value_after_dollar(&ARGS[i][1], (int) strlen(ARGS[i]) - 2),
-                                       ARGS[i][(int) strlen(ARGS[i]) - 1]);
-                            } else { //if the variable is not found, print the word without "
-                                printf("%s ", &ARGS[i][1]);
-                            }
-                        } else { //if there is no punctuation mark after the '$VAR' print the value of the variable normally without "
-                            if (strcasecmp(get_value_after_dollar(&ARGS[i][1], (int) strlen(ARGS[i]) - 1), "") != 0) {
-                                printf("%s ", get_value_after_dollar(&ARGS[i][1], (int) strlen(ARGS[i]) - 1));
-                            } else { //if the variable is not found, print the word without "
-                                printf("%s ", &ARGS[i][1]);
-                            }
-                        }
-                    } else { //if there is $, print the word without the "
-                        printf("%s ", &ARGS[i][1]);
-                    }
-                } else if (ARGS[i][(int) strlen(ARGS[i]) - 1] == '"') { //check for " at end of word
-                    //check for $ at the beginning
-                    if (ARGS[i][0] == '$') {
-                        //check for a punctuation mark exactly at the end of '$VAR'
-                        if (ARGS[i][(int) strlen(ARGS[i]) - 2] == ',' ||
-                            ARGS[i][(int) strlen(ARGS[i]) - 2] == '.' ||
-                            ARGS[i][(int) strlen(ARGS[i]) - 2] == '!' ||
-                            ARGS[i][(int) strlen(ARGS[i]) - 2] == '?') {
-                            char temp_arg[MAX_LENGTH] = {0};
-                            strncpy(temp_arg, ARGS[i], strlen(ARGS[i]) - 2);
-                            //if the variable is found print the value of the variable with the punctuation mark at the end
-                            if (strcasecmp(get_value_after_dollar(temp_arg, (int) strlen(ARGS[i]) - 2), "") != 0) {
-                                printf("%s%c ", get_value_after_dollar(temp_arg, (int) strlen(ARGS[i]) - 2),
-                                       ARGS[i][(int) strlen(ARGS[i]) - 2]);
-                            } else { //if the variable is not found, print the word without "
-                                printf("%.*s ", (int) (strlen(ARGS[i]) - 1), ARGS[i]);
-                            }
-                        } else { //if there is no punctuation mark after the '$VAR' print the value of the variable normally
-                            char temp_arg[MAX_LENGTH] = {0};
-                            strncpy(temp_arg, ARGS[i], strlen(ARGS[i]) - 1);
-                            //if the variable is found print the value of the variable without " at the end
-                            if (strcasecmp(get_value_after_dollar(temp_arg, (int) strlen(ARGS[i]) - 1), "") != 0) {
-                                printf("%s ", get_value_after_dollar(temp_arg, (int) strlen(ARGS[i]) - 1));
-                            } else { //if the variable is not found print the word without " at the end
-                                printf("%.*s ", (int) (strlen(ARGS[i]) - 1), ARGS[i]);
-                            }
-                        }
-                    } else { //if the word does not have $, print the word without " at the end
-                        printf("%.*s ", (int) (strlen(ARGS[i]) - 1), ARGS[i]);
-                    }
-                } else { //if there are no " in the word, just check for $ and punctuation, otherwise print the word normally
-                    if (ARGS[i][0] == '$') {
-                        if (ARGS[i][(int) strlen(ARGS[i]) - 1] == ',' ||
-                            ARGS[i][(int) strlen(ARGS[i]) - 1] == '.' ||
-                            ARGS[i][(int) strlen(ARGS[i]) - 1] == '!' ||
-                            ARGS[i][(int) strlen(ARGS[i]) - 1] == '?') {
-                            if (strcasecmp(get_value_after_dollar(ARGS[i], (int) strlen(ARGS[i]) - 1), "") != 0) {
-                                printf("%s%c ", get_value_after_dollar(ARGS[i], (int) strlen(ARGS[i]) - 1),
-                                       ARGS[i][(int) strlen(ARGS[i]) - 1]);
-                            } else {
-                                printf("%s ", ARGS[i]);
-                            }
-                        } else {
-                            if (strcasecmp(get_value_after_dollar(ARGS[i], (int) strlen(ARGS[i])), "") != 0) {
-                                printf("%s ", get_value_after_dollar(ARGS[i], (int) strlen(ARGS[i])));
-                            } else {
-                                printf("%s ", ARGS[i]);
-                            }
-                        }
-                    } else {
-                        printf("%s ", ARGS[i]);
-                    }
+    if (empty) {
+        printf("hash table empty\n");
+    }
+}
+
+//function which executes the hash command
+//'hash' prints the table, 'hash -r' clears it and 'hash NAME...' adds the given commands
+//returns 0 if every command was found, returns 1 otherwise
+int hash_command(struct interpreter *interpreter) {
+    int exit_code = 0;
+
+    if (interpreter->arg_count == 1) {
+        print_command_hash();
+        return exit_code;
+    }
+
+    for (int i = 1; i < interpreter->arg_count; i++) {
+        if (strcmp(interpreter->args[i], "-r") == 0) {
+            clear_command_hash();
+        } else if (get_command_path(interpreter->args[i]) == NULL) {
+            printf("hash: %s: not found\n", interpreter->args[i]);
+            exit_code = EXIT_FAILURE;
+        }
+    }
+
+    return exit_code;
+}
+
+//handler for SIGCHLD which reaps every finished process of a background job
+//only the pids in the job table are waited for, so foreground commands are left to their own waitpid
+void sigchld_handler(int signal_number) {
+    int saved_errno = errno;
+
+    //the handler is only installed for SIGCHLD, so the signal number is not needed
+    (void) signal_number;
+
+    for (int i = 0; i < MAX_JOBS; i++) {
+        if (JOBS[i].id == 0) {
+            continue;
+        }
+
+        for (int j = 0; j < JOBS[i].process_count; j++) {
+            int wait_val;
+
+            if (JOBS[i].pids[j] > 0 && waitpid(JOBS[i].pids[j], &wait_val, WNOHANG) == JOBS[i].pids[j]) {
+                JOBS[i].pids[j] = 0;
+                JOBS[i].running--;
+
+                //the exit code of a job is the exit code of its last process
+                if (j == JOBS[i].process_count - 1) {
+                    JOBS[i].exit_code = wait_status_to_exit_code(wait_val);
                 }
             }
         }
-        printf("\n");
-    } else { //if the number of " in the input is greater or equal to 2
-        for (int i = 1; i < INPUT_ARGS_COUNT; i++) {
-            if (print_literal == 0) { //this checks whether a " has already benn found
-                //checking for special case where a word contains a " both at the beginning and end
-                if (ARGS[i][0] == '"' && ARGS[i][strlen(ARGS[i]) - 1] == '"' && strlen(ARGS[i]) > 1) {
-                    printf("%.*s ", (int) (strlen(ARGS[i]) - 2), &ARGS[i][1]);
-                } else {
-                    //assuming first quote is the beginning of a string
-                    if (ARGS[i][0] == '"') {
-                        if (strlen(ARGS[i]) > 1) {
-                            printf("%s ", &ARGS[i][1]);
-                            print_literal = 1;
-                        } else { //this else is to ensure that " on their own also cout
-                            print_literal = 1;
-                        }
-                    } else {
-                        //check for $ at the beginning of a string
-                        if (ARGS[i][0] == '$') {
-                            //check for punctuation marks at the end of a string
-                            if (ARGS[i][(int) strlen(ARGS[i]) - 1] == ',' ||
-                                ARGS[i][(int) strlen(ARGS[i]) - 1] == '.' ||
-                                ARGS[i][(int) strlen(ARGS[i]) - 1] == '!' ||
-                                ARGS[i][(int) strlen(ARGS[i]) - 1] == '?') {
-                                //check for a variable, if it exists, print the value with the punctuation mark at the end
-                                if (strcasecmp(get_value_after_dollar(ARGS[i], (int) strlen(ARGS[i]) - 1), "") != 0) {
-                                    printf("%s%c ", get_value_after_dollar(ARGS[i], (int) strlen(ARGS[i]) - 1),
-                                           ARGS[i][(int) strlen(ARGS[i]) - 1]);
-                                } else { //if the variable does not exist, print the word normally
-                                    printf("%s ", ARGS[i]);
-                                }
-                            } else { //if there is no punctuation mark print the value if the variable is found
-                                if (strcasecmp(get_value_after_dollar(ARGS[i], (int) strlen(ARGS[i])), "") != 0) {
-                                    printf("%s ", get_value_after_dollar(ARGS[i], (int) strlen(ARGS[i])));
-                                } else { //if the variable does not exist, print the word normally
-                                    printf("%s ", ARGS[i]);
-                                }
-                            }
-                        } else { //if the string does not have $ at the beginning, print the word normally
-                            printf("%s ", ARGS[i]);
-                        }
-                    }
-                }
-            } else { //if a " has already been found
-                //assuming second quote is in the end of a string
-                int second_quote = check_for_char_in_string(ARGS[i], (int) strlen(ARGS[i]), '"');
-                if (second_quote != -1) {
-                    if (strlen(ARGS[i]) >
-                        1) { //if a second " has been found change the value to start printing variable values
-                        printf("%.*s ", second_quote, ARGS[i]);
-                        print_literal = 0;
-                    } else {
-                        print_literal = 0;
-                    }
-                } else { //if no second quote is found, print words as they are
-                    printf("%s ", ARGS[i]);
+    }
+
+    errno = saved_errno;
+}
+
+//function which blocks SIGCHLD so that the job table can be changed safely
+//the previous signal mask is stored in old_set so that it can be restored with sigprocmask
+void block_sigchld(sigset_t *old_set) {
+    sigset_t block_set;
+
+    sigemptyset(&block_set);
+    sigaddset(&block_set, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &block_set, old_set);
+}
+
+//function which adds a job to the first free slot in the job table
+//SIGCHLD must be blocked while this is called
+//returns the id of the job, or -1 if the job table is full
+int add_job(pid_t pgid, const pid_t pids[], int process_count, const char command[]) {
+    for (int i = 0; i < MAX_JOBS; i++) {
+        if (JOBS[i].id == 0) {
+            JOBS[i].pgid = pgid;
+            JOBS[i].pids = malloc(process_count * sizeof(pid_t));
+            JOBS[i].process_count = process_count;
+            JOBS[i].running = 0;
+            JOBS[i].exit_code = EXIT_FAILURE;
+            JOBS[i].command = strdup(command);
+
+            //processes which could not be started are counted as already finished
+            for (int j = 0; j < process_count; j++) {
+                JOBS[i].pids[j] = pids[j] > 0 ? pids[j] : 0;
+                if (pids[j] > 0) {
+                    JOBS[i].running++;
                 }
             }
 
+            JOBS[i].id = i + 1;
+            return JOBS[i].id;
         }
-        printf("\n");
     }
+
+    printf("Too many background jobs, the job will not be tracked.\n");
+    return -1;
 }
 
-//function which checks the CWD and the given path and changes it, if it is valid
-void change_directory(char path[]) {
-    int last_slash_pos = 0;
-    char cwd_before_change[MAX_LENGTH];
+//function which frees the slot of a job in the job table
+//SIGCHLD must be blocked while this is called
+void remove_job(struct job *job) {
+    job->id = 0;
+    free(job->pids);
+    free(job->command);
+    job->pids = NULL;
+    job->command = NULL;
+}
 
-    //keep a copy of the CWD, in case the new one is invalid
-    strncpy(cwd_before_change, CWD, strlen(CWD));
+//function which blocks until every process of a job has finished and stores its exit code in EXITCODE
+//the job is removed from the job table
+void wait_for_job(struct job *job) {
+    sigset_t old_set;
 
-    //check is .. was entered
-    if (strcasecmp(path, "..") != 0) {
-        //check if the path is valid
-        if (chdir(path) != 0) {
-            perror("Cannot change directory");
-        } else { //if the path is valid, change the variable CWD
-            clear_string(CWD, MAX_LENGTH);
-            if (getcwd(CWD, sizeof(CWD)) == NULL) {
-                perror("Cannot set current working directory");
+    //the processes are waited for here, so the handler must not reap them at the same time
+    block_sigchld(&old_set);
+
+    for (int i = 0; i < job->process_count; i++) {
+        int wait_val;
+
+        if (job->pids[i] > 0 && waitpid(job->pids[i], &wait_val, 0) == job->pids[i]) {
+            job->pids[i] = 0;
+            job->running--;
+
+            if (i == job->process_count - 1) {
+                job->exit_code = wait_status_to_exit_code(wait_val);
             }
         }
-    } else { //if .. was entered
-        //find the last / in the path
-        for (int i = (int) strlen(CWD) - 1; i >= 0; i--) {
-            if (CWD[i] == '/') {
-                last_slash_pos = i;
-                break;
-            }
+    }
+
+    EXITCODE = job->exit_code;
+    remove_job(job);
+
+    sigprocmask(SIG_SETMASK, &old_set, NULL);
+}
+
+//function which prints every background job which has finished and removes it from the job table
+//this is called before the prompt is shown, only when the input is typed in the terminal
+void report_finished_jobs() {
+    sigset_t old_set;
+
+    if (!INTERACTIVE) {
+        return;
+    }
+
+    block_sigchld(&old_set);
+
+    for (int i = 0; i < MAX_JOBS; i++) {
+        if (JOBS[i].id != 0 && JOBS[i].running == 0) {
+            printf("[%d] Done (%d)\t%s\n", JOBS[i].id, JOBS[i].exit_code, JOBS[i].command);
+            remove_job(&JOBS[i]);
         }
+    }
+
+    sigprocmask(SIG_SETMASK, &old_set, NULL);
+}
+
+//function which executes the jobs command
+//prints every background job, finished jobs are removed from the job table after they are printed
+void jobs_command() {
+    sigset_t old_set;
 
-        //clear from the position of the last / to the end
-        for (int i = last_slash_pos; i < (int) strlen(CWD); i++) {
-            CWD[i] = '\0';
+    block_sigchld(&old_set);
+
+    for (int i = 0; i < MAX_JOBS; i++) {
+        if (JOBS[i].id == 0) {
+            continue;
         }
 
-        //check if the new path is valid, if it is not valid, revert to the old value
-        if (chdir(CWD) != 0) {
-            perror("Cannot change directory");
-            strncpy(CWD, cwd_before_change, strlen(cwd_before_change));
-        } else { //if the path is valid, change the variable CWD
-            clear_string(CWD, MAX_LENGTH);
-            if (getcwd(CWD, sizeof(CWD)) == NULL) {
-                perror("Cannot set current working directory");
-            }
+        if (JOBS[i].running > 0) {
+            printf("[%d] %d Running\t%s\n", JOBS[i].id, JOBS[i].pgid, JOBS[i].command);
+        } else {
+            printf("[%d] %d Done (%d)\t%s\n", JOBS[i].id, JOBS[i].pgid, JOBS[i].exit_code, JOBS[i].command);
+            remove_job(&JOBS[i]);
         }
     }
-}
 
-//function to run a simple fork-plus-exec to execute external commands
-void execute_external_command(const char command[], int redirect) {
-    int wait_val;
+    sigprocmask(SIG_SETMASK, &old_set, NULL);
+}
 
-    //fork the main branch
-    pid_t pid = fork();
+//function which executes the wait command
+//'wait' waits for every background job, 'wait ID...' waits for the given jobs, written as N or %N
+//EXITCODE is set to the exit code of the last job waited for
+void wait_command(struct interpreter *interpreter) {
+    EXITCODE = 0;
 
-    //check if the fork was valid
-    if (pid < 0) {
-        perror("Unable to fork");
-        exit(EXIT_FAILURE);
-    } else if (pid == 0) { //if the fork is valid, check if it is in the child
-        if (redirect == 1) { //check if the output has been redirected using '>'
-            char filename[MAX_LENGTH];
-            strncpy(filename, ARGS[INPUT_ARGS_COUNT - 1], strlen(ARGS[INPUT_ARGS_COUNT - 1]));
-
-            clear_string(ARGS[INPUT_ARGS_COUNT - 1], (int) strlen(ARGS[INPUT_ARGS_COUNT - 1]));
-            clear_string(ARGS[INPUT_ARGS_COUNT - 2], (int) strlen(ARGS[INPUT_ARGS_COUNT - 2]));
-            ARGS[INPUT_ARGS_COUNT - 1] = NULL;
-            ARGS[INPUT_ARGS_COUNT - 2] = NULL;
-
-            INPUT_ARGS_COUNT = INPUT_ARGS_COUNT - 2;
-
-            //open the file in read-write-truncate mode and create a new file if it is not found
-            int fd = open(filename, O_RDWR | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR | S_IXUSR);
-            if (fd > 0) {
-                //redirect STDOUT to file
-                dup2(fd, 1);
-                //execute external command through execvp which uses the variable PATH
-                if (execvp(command, ARGS)) {
-                    perror("Exec failed");
-                    exit(EXIT_FAILURE);
-                }
-                //close the file
-                close(fd);
-                exit(EXIT_SUCCESS);
-            } else {
-                perror("Unable to open file");
-                exit(EXIT_FAILURE);
+    if (interpreter->arg_count == 1) {
+        for (int i = 0; i < MAX_JOBS; i++) {
+            if (JOBS[i].id != 0) {
+                wait_for_job(&JOBS[i]);
             }
-        } else if (redirect == 2) { //check if the output has been redirected using '>>'
-            char filename[MAX_LENGTH];
-            strncpy(filename, ARGS[INPUT_ARGS_COUNT - 1], strlen(ARGS[INPUT_ARGS_COUNT - 1]));
-
-            clear_string(ARGS[INPUT_ARGS_COUNT - 1], (int) strlen(ARGS[INPUT_ARGS_COUNT - 1]));
-            clear_string(ARGS[INPUT_ARGS_COUNT - 2], (int) strlen(ARGS[INPUT_ARGS_COUNT - 2]));
-            ARGS[INPUT_ARGS_COUNT - 1] = NULL;
-            ARGS[INPUT_ARGS_COUNT - 2] = NULL;
-
-            INPUT_ARGS_COUNT = INPUT_ARGS_COUNT - 2;
-
-            //open the file in read-write-append mode
-            int fd = open(filename, O_RDWR | O_APPEND, S_IRUSR | S_IWUSR | S_IXUSR);
-            if (fd > 0) {
-                //redirect STDOUT to file
-                dup2(fd, 1);
-                //execute external command
-                if (execvp(command, ARGS)) {
-                    perror("Exec failed");
-                    exit(EXIT_FAILURE);
-                }
-                //close the file
-                close(fd);
-                exit(EXIT_SUCCESS);
+        }
+    } else {
+        for (int i = 1; i < interpreter->arg_count; i++) {
+            int job_id = atoi(interpreter->args[i][0] == '%' ? &interpreter->args[i][1] : interpreter->args[i]);
+
+            if (job_id < 1 || job_id > MAX_JOBS || JOBS[job_id - 1].id == 0) {
+                printf("wait: %s: no such job\n", interpreter->args[i]);
+                EXITCODE = 127;
             } else {
-                perror("Unable to open file");
-                exit(EXIT_FAILURE);
-            }
-        } else { //if the output has not been redirected, execute normally
-            if (execvp(command, ARGS)) {
-                perror("Exec failed");
-                exit(EXIT_FAILURE);
+                wait_for_job(&JOBS[job_id - 1]);
             }
         }
     }
 
-    wait(&wait_val);
+    set_exit_code(EXITCODE);
+}
+
+//function which returns the time of the monotonic clock in seconds
+double get_monotonic_time() {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
 
-    if (WIFEXITED(wait_val)) {
-        EXITCODE = WEXITSTATUS(wait_val);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+//function which converts a timeval from struct rusage to seconds
+double timeval_to_seconds(struct timeval time) {
+    return (double) time.tv_sec + (double) time.tv_usec / 1e6;
+}
+
+//function which clears the resource usage of the last command before a new foreground command starts
+void start_command_usage() {
+    memset(&LAST_USAGE, 0, sizeof(LAST_USAGE));
+}
+
+//function which adds the resources used by one reaped process to the usage of the last command
+//the times and context switches of all the stages of a pipeline are added up, the largest RSS is kept
+void add_command_usage(const struct rusage *usage) {
+    LAST_USAGE.user_time += timeval_to_seconds(usage->ru_utime);
+    LAST_USAGE.system_time += timeval_to_seconds(usage->ru_stime);
+    LAST_USAGE.voluntary_switches += usage->ru_nvcsw;
+    LAST_USAGE.involuntary_switches += usage->ru_nivcsw;
+
+    if (usage->ru_maxrss > LAST_USAGE.max_rss) {
+        LAST_USAGE.max_rss = usage->ru_maxrss;
     }
+}
 
-    clear_string(EXITCODE_S, (int) strlen(EXITCODE_S));
-    sprintf(EXITCODE_S, "%d", EXITCODE);
-}
\ No newline at end of file
+//function which stores the wall-clock time of the last command and updates the LAST variables
+void finish_command_usage(double start_time) {
+    LAST_USAGE.wall_time = get_monotonic_time() - start_time;
+
+    sprintf(LASTUSER_S, "%f", LAST_USAGE.user_time);
+    sprintf(LASTSYS_S, "%f", LAST_USAGE.system_time);
+    sprintf(LASTWALL_S, "%f", LAST_USAGE.wall_time);
+    sprintf(LASTRSS_S, "%ld", LAST_USAGE.max_rss);
+}
+
+//function which executes the times command
+//prints the resources used by the last foreground command, then the totals for the shell and its children
+void times_command() {
+    struct rusage shell_usage, children_usage;
+
+    printf("last:     real %.6fs user %.6fs sys %.6fs maxrss %ldKB voluntary ctxsw %ld involuntary ctxsw %ld\n",
+           LAST_USAGE.wall_time, LAST_USAGE.user_time, LAST_USAGE.system_time, LAST_USAGE.max_rss,
+           LAST_USAGE.voluntary_switches, LAST_USAGE.involuntary_switches);
+
+    getrusage(RUSAGE_SELF, &shell_usage);
+    getrusage(RUSAGE_CHILDREN, &children_usage);
+
+    printf("shell:    user %.6fs sys %.6fs\n",
+           timeval_to_seconds(shell_usage.ru_utime), timeval_to_seconds(shell_usage.ru_stime));
+    printf("children: user %.6fs sys %.6fs\n",
+           timeval_to_seconds(children_usage.ru_utime), timeval_to_seconds(children_usage.ru_stime));
+}
@@ -0,0 +1,64 @@
+#!/bin/sh
+# checks the exit status of eggsh for 'exit', 'exit n' and the last command of -c, a script and standard input,
+# and the status of builtins which fail
+# usage: tests/exit_status.sh <eggsh>
+
+EGGSH="$1"
+FAILED=0
+
+if [ -z "$EGGSH" ]; then
+    echo "usage: $0 <eggsh>" >&2
+    exit 2
+fi
+
+SCRIPT=$(mktemp)
+trap 'rm -f "$SCRIPT"' EXIT
+
+check() {
+    if [ "$1" -ne "$2" ]; then
+        echo "FAIL: $3: expected $2, got $1"
+        FAILED=1
+    else
+        echo "ok: $3"
+    fi
+}
+
+"$EGGSH" -c 'exit 3' > /dev/null; check $? 3 "-c 'exit 3'"
+"$EGGSH" -c 'false; exit' > /dev/null; check $? 1 "-c 'false; exit'"
+"$EGGSH" -c 'true; exit' > /dev/null; check $? 0 "-c 'true; exit'"
+"$EGGSH" -c 'false' > /dev/null; check $? 1 "-c 'false'"
+"$EGGSH" -c 'exit 300' > /dev/null; check $? 44 "-c 'exit 300'"
+"$EGGSH" -c 'exit abc' > /dev/null; check $? 1 "-c 'exit abc'"
+"$EGGSH" -c 'exit 2; exit 5' > /dev/null; check $? 2 "-c 'exit 2; exit 5'"
+"$EGGSH" -c 'f() { exit 6; }; f; exit 1' > /dev/null; check $? 6 "exit in a function"
+
+# builtins which fail set the status as well
+"$EGGSH" -c 'hash nosuchcmd' > /dev/null; check $? 1 "-c 'hash nosuchcmd'"
+"$EGGSH" -c 'hash -r' > /dev/null; check $? 0 "-c 'hash -r'"
+
+# a command which cannot be found gives 127, a file which cannot be executed gives 126
+"$EGGSH" -c 'nosuchcmd_eggsh' > /dev/null 2>&1; check $? 127 "-c 'nosuchcmd_eggsh'"
+"$EGGSH" -c 'print a | nosuchcmd_eggsh' > /dev/null 2>&1; check $? 127 "-c 'print a | nosuchcmd_eggsh'"
+printf 'print a\n' > "$SCRIPT"
+chmod -x "$SCRIPT"
+"$EGGSH" -c "$SCRIPT" > /dev/null 2>&1; check $? 126 "file which is not executable"
+
+# a command killed by a signal gives 128 plus the number of the signal
+"$EGGSH" -c "true; sh -c 'kill -9 \$\$'; exit" > /dev/null 2>&1; check $? 137 "command killed by SIGKILL"
+"$EGGSH" -c "true; print a | sh -c 'kill -15 \$\$'; exit" > /dev/null 2>&1; check $? 143 "pipeline stage killed by SIGTERM"
+
+printf 'print a\nexit 4\nprint b\n' > "$SCRIPT"
+"$EGGSH" "$SCRIPT" > /dev/null; check $? 4 "script with 'exit 4'"
+
+# a $((...)) which cannot be evaluated stops its command and keeps the failing status
+"$EGGSH" -c 'print $((10/0))' > /dev/null; check $? 1 "-c 'print \$((10/0))'"
+"$EGGSH" -c 'print $((10/0)); exit' > /dev/null; check $? 1 "-c 'print \$((10/0)); exit'"
+"$EGGSH" -c 'X=$((10/0))' > /dev/null; check $? 1 "-c 'X=\$((10/0))'"
+
+# a script which sources itself is stopped with an error instead of running out of stack
+printf 'source %s\n' "$SCRIPT" > "$SCRIPT"
+"$EGGSH" -c "source $SCRIPT" > /dev/null; check $? 1 "script which sources itself"
+
+printf 'print a\nfalse\nexit\n' | "$EGGSH" > /dev/null; check $? 1 "'false; exit' on standard input"
+
+exit $FAILED
@@ -0,0 +1,32 @@
+#!/bin/sh
+# checks the output of nested $(...), including inner ones which fork inside an outer one which runs in the shell
+# usage: tests/substitution.sh <eggsh>
+
+EGGSH="$1"
+FAILED=0
+
+if [ -z "$EGGSH" ]; then
+    echo "usage: $0 <eggsh>" >&2
+    exit 2
+fi
+
+check() {
+    OUTPUT=$("$EGGSH" -c "$1" 2>&1)
+    if [ "$OUTPUT" != "$2" ]; then
+        echo "FAIL: $1: expected '$2', got '$OUTPUT'"
+        FAILED=1
+    else
+        echo "ok: $1"
+    fi
+}
+
+check 'print [$(print a)]' '[a]'
+check 'print [$(print [$(print b)])]' '[[b]]'
+check 'print [$(print [$(print b; true)])]' '[[b]]'
+check 'print [$(print [$(print a | cat)])]' '[[a]]'
+check 'f() { print ff; }; print [$(print [$(f; true)])]' '[[ff]]'
+check 'f(){ print ff; }; print [$(print [$(f; true)])]' '[[ff]]'
+check 'print [$(print [$(print [$(print deep; true)])])]' '[[[deep]]]'
+check 'print [$(true; print [$(print x)] | cat)]' '[[x]]'
+
+exit $FAILED